@@ -225,6 +225,72 @@ def write_model_devi_out(
     return devi
 
 
+def read_model_devi_atomic_bin(fname: str) -> list[tuple[int, np.ndarray]]:
+    """Read the atomic model deviation of force written by LAMMPS in binary.
+
+    The file is written by the keyword `atomic_file` of `pair_style deepmd`.
+    Each frame contains a header of three int64 numbers, which are the step,
+    the number of atoms, and the number of records, followed by the int64 tags
+    and then the float64 model deviations of the records.
+
+    Parameters
+    ----------
+    fname : str
+        the binary file
+
+    Returns
+    -------
+    list[tuple[int, np.ndarray]]
+        the step and the model deviation of each atom, ordered by the tags,
+        of each frame; atoms not recorded have the deviation of zero
+    """
+    data = np.fromfile(fname, dtype=np.uint8)
+    frames = []
+    pos = 0
+    while pos < data.size:
+        step, natoms, nrec = np.frombuffer(
+            data, dtype=np.int64, count=3, offset=pos
+        )
+        pos += 3 * 8
+        tags = np.frombuffer(data, dtype=np.int64, count=nrec, offset=pos)
+        pos += nrec * 8
+        devi = np.frombuffer(data, dtype=np.float64, count=nrec, offset=pos)
+        pos += nrec * 8
+        atm_devi = np.zeros(natoms, dtype=np.float64)
+        atm_devi[tags - 1] = devi
+        frames.append((int(step), atm_devi))
+    return frames
+
+
+def restore_model_devi_atomic(out_file: str, atomic_file: str, output: str) -> None:
+    """Restore the model deviation output of LAMMPS with the atomic columns.
+
+    The output is the same as the one written with the keyword `atomic`
+    of `pair_style deepmd` instead of `atomic_file`.
+
+    Parameters
+    ----------
+    out_file : str
+        the model deviation file written by LAMMPS
+    atomic_file : str
+        the binary atomic model deviation file written by LAMMPS
+    output : str
+        the file to write
+    """
+    atomic = dict(read_model_devi_atomic_bin(atomic_file))
+    with open(out_file) as fin, open(output, "w") as fout:
+        for line in fin:
+            line = line.rstrip("\n")
+            if line.startswith("#"):
+                if "atm_devi_f(N)" not in line:
+                    line += f"{'atm_devi_f(N)':>19s}"
+            elif line.strip():
+                step = int(line.split()[0])
+                if step in atomic:
+                    line += "".join(f" {dd:18.6e}" for dd in atomic[step])
+            fout.write(line + "\n")
+
+
 def _check_tmaps(tmaps, ref_tmap=None):
     """Check whether type maps are identical."""
     assert isinstance(tmaps, list)
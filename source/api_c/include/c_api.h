@@ -12,7 +12,7 @@ extern "C" {
 /** C API version. Bumped whenever the API is changed.
  * @since API version 22
  */
-#define DP_C_API_VERSION 25
+#define DP_C_API_VERSION 26
 
 /**
  * @brief Neighbor list.
@@ -171,6 +171,24 @@ extern DP_DeepPot* DP_NewDeepPotWithParam2(const char* c_model,
                                            const char* c_file_content,
                                            const int size_file_content);
 
+/**
+ * @brief DP constructor with initialization and a thread budget.
+ * @version 3
+ * @param c_model The name of the frozen model file.
+ * @param gpu_rank The rank of the GPU.
+ * @param c_file_content The content of the model file.
+ * @param size_file_content The size of the model file.
+ * @param nthreads The number of threads used by this DP. If it is positive,
+ * it overrides the environment variables of the parallelism.
+ * @return DP_DeepPot* A pointer to the deep potential.
+ * @since API version 26
+ */
+extern DP_DeepPot* DP_NewDeepPotWithParam3(const char* c_model,
+                                           const int gpu_rank,
+                                           const char* c_file_content,
+                                           const int size_file_content,
+                                           const int nthreads);
+
 /**
  * @brief Delete a Deep Potential.
  *
@@ -835,6 +853,30 @@ extern DP_DeepPotModelDevi* DP_NewDeepPotModelDeviWithParam(
     const int n_file_contents,
     const int* size_file_contents);
 
+/**
+ * @brief DP model deviation constructor with initialization and a thread
+ * budget.
+ * @version 2
+ * @param[in] c_models The array of the name of the frozen model file.
+ * @param[in] nmodels The number of models.
+ * @param[in] gpu_rank The rank of the GPU.
+ * @param[in] c_file_contents The contents of the model file.
+ * @param[in] n_file_contents The number of the contents of the model file.
+ * @param[in] size_file_contents The sizes of the contents of the model file.
+ * @param[in] nthreads The number of threads used by each model. If it is
+ * positive, it overrides the environment variables of the parallelism.
+ * @return DP_DeepPotModelDevi* A pointer to the deep potential model deviation.
+ * @since API version 26
+ */
+extern DP_DeepPotModelDevi* DP_NewDeepPotModelDeviWithParam2(
+    const char** c_model,
+    const int n_models,
+    const int gpu_rank,
+    const char** c_file_contents,
+    const int n_file_contents,
+    const int* size_file_contents,
+    const int nthreads);
+
 /**
  * @brief Delete a Deep Potential Model Deviation.
  *
@@ -2226,6 +2268,24 @@ extern void DP_ConvertPbtxtToPb(const char* c_pbtxt, const char* c_pb);
  */
 extern void DP_PrintSummary(const char* c_pre);
 
+/**
+ * @brief Bind the calling thread to the cores assigned to a rank on a node.
+ * The thread pools created afterwards inherit the binding.
+ * @param[in] node_rank The rank on the node.
+ * @param[in] node_nranks The number of ranks on the node.
+ * @return int The number of bound cores, or 0 if nothing is done.
+ * @since API version 26
+ */
+extern int DP_BindNodeCores(const int node_rank, const int node_nranks);
+
+/**
+ * @brief Check whether the model is a memmapped TensorFlow package.
+ * @param[in] c_model The name of the model.
+ * @return bool Whether the model name ends with .pbmm.
+ * @since API version 26
+ */
+extern bool DP_IsMemmappedModel(const char* c_model);
+
 /**
  * @brief Read a file to a char array.
  * @param[in] c_model The name of the file.
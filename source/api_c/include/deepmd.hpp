@@ -1022,13 +1022,16 @@ class DeepPot : public DeepBaseModel {
    * @param[in] model The name of the frozen model file.
    * @param[in] gpu_rank The GPU rank.
    * @param[in] file_content The content of the frozen model file.
+   * @param[in] nthreads The number of threads used by this DP. If it is
+   * positive, it overrides the environment variables of the parallelism.
    **/
   DeepPot(const std::string &model,
           const int &gpu_rank = 0,
-          const std::string &file_content = "")
+          const std::string &file_content = "",
+          const int &nthreads = 0)
       : dp(nullptr) {
     try {
-      init(model, gpu_rank, file_content);
+      init(model, gpu_rank, file_content, nthreads);
     } catch (...) {
       // Clean up and rethrow, as the destructor will not be called
       if (dp) {
@@ -1042,18 +1045,21 @@ class DeepPot : public DeepBaseModel {
    * @param[in] model The name of the frozen model file.
    * @param[in] gpu_rank The GPU rank.
    * @param[in] file_content The content of the frozen model file.
+   * @param[in] nthreads The number of threads used by this DP. If it is
+   * positive, it overrides the environment variables of the parallelism.
    **/
   void init(const std::string &model,
             const int &gpu_rank = 0,
-            const std::string &file_content = "") {
+            const std::string &file_content = "",
+            const int &nthreads = 0) {
     if (dp) {
       std::cerr << "WARNING: deepmd-kit should not be initialized twice, do "
                    "nothing at the second call of initializer"
                 << std::endl;
       return;
     }
-    dp = DP_NewDeepPotWithParam2(model.c_str(), gpu_rank, file_content.c_str(),
-                                 file_content.size());
+    dp = DP_NewDeepPotWithParam3(model.c_str(), gpu_rank, file_content.c_str(),
+                                 file_content.size(), nthreads);
     DP_CHECK_OK(DP_DeepPotCheckOK, dp);
     dfparam = DP_DeepPotGetDimFParam(dp);
     daparam = DP_DeepPotGetDimAParam(dp);
@@ -1326,6 +1332,73 @@ class DeepPot : public DeepBaseModel {
                                        atomic_ener_, atomic_virial_);
     DP_CHECK_OK(DP_DeepPotCheckOK, dp);
   };
+  /**
+   * @brief Evaluate the energy, force, virial, atomic energy, and atomic virial
+   *by using this DP with the neighbor list, writing the results directly into
+   *caller-provided buffers.
+   * @param[out] ener The system energy.
+   * @param[out] force The force on each atom. The buffer should be of size
+   *natoms x 3.
+   * @param[out] virial The virial. The buffer should be of size 9. If it is
+   *nullptr, the virial is not computed when the backend supports it.
+   * @param[out] atom_energy The atomic energy. The buffer should be of size
+   *natoms. If atom_energy or atom_virial is nullptr, the atomic energy and
+   *virial are not computed.
+   * @param[out] atom_virial The atomic virial. The buffer should be of size
+   *natoms x 9.
+   * @param[in] coord The coordinates of atoms. The array should be of size
+   *natoms x 3.
+   * @param[in] atype The atom types. The list should contain natoms ints.
+   * @param[in] box The cell of the region. The array should be of size 9
+   *(PBC) or empty (no PBC).
+   * @param[in] nghost The number of ghost atoms.
+   * @param[in] lmp_list The input neighbour list.
+   * @param[in] ago Update the internal neighbour list if ago is 0.
+   * @param[in] fparam The frame parameter. The array can be of size
+   *dim_fparam.
+   * @param[in] aparam The atomic parameter The array can be of size
+   *natoms x dim_aparam.
+   **/
+  template <typename VALUETYPE>
+  void compute(
+      double &ener,
+      VALUETYPE *force,
+      VALUETYPE *virial,
+      VALUETYPE *atom_energy,
+      VALUETYPE *atom_virial,
+      const std::vector<VALUETYPE> &coord,
+      const std::vector<int> &atype,
+      const std::vector<VALUETYPE> &box,
+      const int nghost,
+      const InputNlist &lmp_list,
+      const int &ago,
+      const std::vector<VALUETYPE> &fparam = std::vector<VALUETYPE>(),
+      const std::vector<VALUETYPE> &aparam = std::vector<VALUETYPE>()) {
+    unsigned int natoms = atype.size();
+    assert(natoms * 3 == coord.size());
+    if (!box.empty()) {
+      assert(box.size() == 9);
+    }
+    const VALUETYPE *coord_ = &coord[0];
+    const VALUETYPE *box_ = !box.empty() ? &box[0] : nullptr;
+    const int *atype_ = &atype[0];
+    const bool atomic = atom_energy != nullptr && atom_virial != nullptr;
+    std::vector<VALUETYPE> fparam_, aparam_;
+    validate_fparam_aparam(1, (aparam_nall ? natoms : (natoms - nghost)),
+                           fparam, aparam);
+    tile_fparam_aparam(fparam_, 1, dfparam, fparam);
+    tile_fparam_aparam(aparam_, 1,
+                       (aparam_nall ? natoms : (natoms - nghost)) * daparam,
+                       aparam);
+    const VALUETYPE *fparam__ = !fparam_.empty() ? &fparam_[0] : nullptr;
+    const VALUETYPE *aparam__ = !aparam_.empty() ? &aparam_[0] : nullptr;
+
+    _DP_DeepPotComputeNList<VALUETYPE>(
+        dp, 1, natoms, coord_, atype_, box_, nghost, lmp_list.nl, ago,
+        fparam__, aparam__, &ener, force, virial,
+        atomic ? atom_energy : nullptr, atomic ? atom_virial : nullptr);
+    DP_CHECK_OK(DP_DeepPotCheckOK, dp);
+  };
   /**
    * @brief Evaluate the energy, force and virial by using this DP with the
    *mixed type.
@@ -2047,11 +2120,14 @@ class DeepPotModelDevi : public DeepBaseModelDevi {
    * @param[in] model The name of the frozen model file.
    * @param[in] gpu_rank The GPU rank.
    * @param[in] file_content The content of the frozen model file.
+   * @param[in] nthreads The number of threads used by each model. If it is
+   * positive, it overrides the environment variables of the parallelism.
    **/
   void init(const std::vector<std::string> &models,
             const int &gpu_rank = 0,
             const std::vector<std::string> &file_content =
-                std::vector<std::string>()) {
+                std::vector<std::string>(),
+            const int &nthreads = 0) {
     if (dp) {
       std::cerr << "WARNING: deepmd-kit should not be initialized twice, do "
                    "nothing at the second call of initializer"
@@ -2073,9 +2149,9 @@ class DeepPotModelDevi : public DeepBaseModelDevi {
       size_file_contents.push_back(str.size());
     }
 
-    dp = DP_NewDeepPotModelDeviWithParam(
+    dp = DP_NewDeepPotModelDeviWithParam2(
         cstrings.data(), cstrings.size(), gpu_rank, c_file_contents.data(),
-        c_file_contents.size(), size_file_contents.data());
+        c_file_contents.size(), size_file_contents.data(), nthreads);
     DP_CHECK_OK(DP_DeepPotModelDeviCheckOK, dp);
     numb_models = models.size();
     dfparam = DP_DeepPotModelDeviGetDimFParam(dp);
@@ -2984,8 +3060,9 @@ class DeepTensor {
   };
 
   /**
-   * @brief Evaluate the tensor, force and virial by using this Deep Tensor.
-   * @param[out] tensor The atomic tensor.
+   * @brief Evaluate the atomic tensor by using this Deep Tensor. Only the
+   *forward pass is run, without the derivatives of the tensor.
+   * @param[out] tensor The atomic tensor of the selected atoms.
    * @param[in] coord The coordinates of atoms. The array should be of size
    *nframes x natoms x 3.
    * @param[in] atype The atom types. The list should contain natoms ints.
@@ -3021,9 +3098,10 @@ class DeepTensor {
   };
 
   /**
-   * @brief Evaluate the tensor, force and virial by using this Deep Tensor with
-   *the neighbor list.
-   * @param[out] tensor The tensor.
+   * @brief Evaluate the atomic tensor by using this Deep Tensor with the
+   *neighbor list. Only the forward pass is run, without the derivatives of the
+   *tensor.
+   * @param[out] tensor The atomic tensor of the local selected atoms.
    * @param[in] coord The coordinates of atoms. The array should be of size
    *nframes x natoms x 3.
    * @param[in] atype The atom types. The list should contain natoms ints.
@@ -3448,6 +3526,25 @@ class DipoleChargeModifier {
   int nsel_types;
 };
 
+/**
+ * @brief Bind the calling thread to the cores assigned to a rank on a node.
+ * @param[in] node_rank The rank on the node.
+ * @param[in] node_nranks The number of ranks on the node.
+ * @return The number of bound cores, or 0 if nothing is done.
+ **/
+int inline bind_node_cores(const int &node_rank, const int &node_nranks) {
+  return DP_BindNodeCores(node_rank, node_nranks);
+};
+
+/**
+ * @brief Check whether the model is a memmapped TensorFlow package.
+ * @param[in] model The name of the model.
+ * @return Whether the model name ends with .pbmm.
+ **/
+bool inline is_memmapped_model(const std::string &model) {
+  return DP_IsMemmappedModel(model.c_str());
+};
+
 /**
  * @brief Read model file to a string.
  * @param[in] model Path to the model.
@@ -98,6 +98,18 @@ DP_DeepPot* DP_NewDeepPotWithParam2(const char* c_model,
   DP_NEW_OK(DP_DeepPot, deepmd::DeepPot dp(model, gpu_rank, file_content);
             DP_DeepPot* new_dp = new DP_DeepPot(dp); return new_dp;)
 }
+
+DP_DeepPot* DP_NewDeepPotWithParam3(const char* c_model,
+                                    const int gpu_rank,
+                                    const char* c_file_content,
+                                    const int size_file_content,
+                                    const int nthreads) {
+  std::string model(c_model);
+  std::string file_content(c_file_content, c_file_content + size_file_content);
+  DP_NEW_OK(DP_DeepPot,
+            deepmd::DeepPot dp(model, gpu_rank, file_content, nthreads);
+            DP_DeepPot* new_dp = new DP_DeepPot(dp); return new_dp;)
+}
 void DP_DeleteDeepPot(DP_DeepPot* dp) { delete dp; }
 
 DP_DeepPotModelDevi::DP_DeepPotModelDevi() {}
@@ -132,6 +144,28 @@ DP_DeepPotModelDevi* DP_NewDeepPotModelDeviWithParam(
             return new_dp;)
 }
 
+DP_DeepPotModelDevi* DP_NewDeepPotModelDeviWithParam2(
+    const char** c_models,
+    const int n_models,
+    const int gpu_rank,
+    const char** c_file_contents,
+    const int n_file_contents,
+    const int* size_file_contents,
+    const int nthreads) {
+  std::vector<std::string> model(c_models, c_models + n_models);
+  std::vector<std::string> file_content;
+  file_content.reserve(n_file_contents);
+  for (int ii = 0; ii < n_file_contents; ++ii) {
+    file_content.push_back(std::string(
+        c_file_contents[ii], c_file_contents[ii] + size_file_contents[ii]));
+  }
+  DP_NEW_OK(
+      DP_DeepPotModelDevi,
+      deepmd::DeepPotModelDevi dp(model, gpu_rank, file_content, nthreads);
+      DP_DeepPotModelDevi* new_dp = new DP_DeepPotModelDevi(dp);
+      return new_dp;)
+}
+
 void DP_DeleteDeepPotModelDevi(DP_DeepPotModelDevi* dp) { delete dp; }
 
 DP_DeepSpin::DP_DeepSpin() {}
@@ -449,6 +483,18 @@ inline void DP_DeepPotComputeNList_variant(DP_DeepPot* dp,
   std::vector<double> e;
   std::vector<VALUETYPE> f, v, ae, av;
 
+  if (nframes == 1 && force && !atomic_energy && !atomic_virial) {
+    // write into the caller's buffers; the virial is skipped if not requested
+    double e0 = 0.;
+    DP_REQUIRES_OK(
+        dp, dp->dp.compute(e0, force, virial, static_cast<VALUETYPE*>(nullptr),
+                           static_cast<VALUETYPE*>(nullptr), coord_, atype_,
+                           cell_, nghost, nlist->nl, ago, fparam_, aparam_));
+    if (energy) {
+      *energy = e0;
+    }
+    return;
+  }
   if (atomic_energy || atomic_virial) {
     DP_REQUIRES_OK(
         dp, dp->dp.compute(e, f, v, ae, av, coord_, atype_, cell_, nghost,
@@ -2388,6 +2434,14 @@ void DP_PrintSummary(const char* c_pre) {
   deepmd::print_summary(pre);
 }
 
+int DP_BindNodeCores(const int node_rank, const int node_nranks) {
+  return deepmd::bind_node_cores(node_rank, node_nranks);
+}
+
+bool DP_IsMemmappedModel(const char* c_model) {
+  return deepmd::is_memmapped_model(std::string(c_model));
+}
+
 const char* DP_ReadFileToChar(const char* c_model) {
   std::string model(c_model);
   std::string file_content;
@@ -109,6 +109,7 @@ class DipoleChargeModifierTF : public DipoleChargeModifierBase {
 
  private:
   tensorflow::Session* session;
+  SessionCallables callables;
   std::string name_scope, name_prefix;
   int num_intra_nthreads, num_inter_nthreads;
   tensorflow::GraphDef* graph_def;
@@ -126,7 +127,7 @@ class DipoleChargeModifierTF : public DipoleChargeModifierBase {
   template <typename MODELTYPE, typename VALUETYPE>
   void run_model(std::vector<VALUETYPE>& dforce,
                  std::vector<VALUETYPE>& dvirial,
-                 tensorflow::Session* session,
+                 SessionCallables& callables,
                  const std::vector<std::pair<std::string, tensorflow::Tensor>>&
                      input_tensors,
                  const AtomMap& atommap,
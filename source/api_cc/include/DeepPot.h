@@ -145,6 +145,62 @@ class DeepPotBackend : public DeepBaseModelBackend {
                         const std::vector<float>& aparam,
                         const bool atomic) = 0;
   /** @} */
+  /**
+   * @brief Evaluate the energy, force, virial, atomic energy, and atomic virial
+   *by using this DP, writing the results into caller-provided buffers.
+   * @details The default implementation calls computew and copies the
+   *results. Backends may override it to avoid the intermediate vectors.
+   * @param[out] ener The system energy.
+   * @param[out] force The force on each atom. The buffer should be of size
+   *natoms x 3.
+   * @param[out] virial The virial. The buffer should be of size 9. If it is
+   *nullptr, the virial is not requested, and the backend may skip computing
+   *it.
+   * @param[out] atom_energy The atomic energy. The buffer should be of size
+   *natoms. Not referenced if atomic is false.
+   * @param[out] atom_virial The atomic virial. The buffer should be of size
+   *natoms x 9. Not referenced if atomic is false.
+   * @param[in] coord The coordinates of atoms. The array should be of size
+   *natoms x 3.
+   * @param[in] atype The atom types. The list should contain natoms ints.
+   * @param[in] box The cell of the region. The array should be of size 9.
+   * @param[in] nghost The number of ghost atoms.
+   * @param[in] lmp_list The input neighbour list.
+   * @param[in] ago Update the internal neighbour list if ago is 0.
+   * @param[in] fparam The frame parameter.
+   * @param[in] aparam The atomic parameter.
+   * @param[in] atomic Request atomic energy and virial if atomic is true.
+   * @{
+   **/
+  virtual void computew_buffer(std::vector<double>& ener,
+                               double* force,
+                               double* virial,
+                               double* atom_energy,
+                               double* atom_virial,
+                               const std::vector<double>& coord,
+                               const std::vector<int>& atype,
+                               const std::vector<double>& box,
+                               const int nghost,
+                               const InputNlist& inlist,
+                               const int& ago,
+                               const std::vector<double>& fparam,
+                               const std::vector<double>& aparam,
+                               const bool atomic);
+  virtual void computew_buffer(std::vector<double>& ener,
+                               float* force,
+                               float* virial,
+                               float* atom_energy,
+                               float* atom_virial,
+                               const std::vector<float>& coord,
+                               const std::vector<int>& atype,
+                               const std::vector<float>& box,
+                               const int nghost,
+                               const InputNlist& inlist,
+                               const int& ago,
+                               const std::vector<float>& fparam,
+                               const std::vector<float>& aparam,
+                               const bool atomic);
+  /** @} */
 
   /**
    * @brief Evaluate the energy, force, and virial with the mixed type
@@ -216,20 +272,28 @@ class DeepPot : public DeepBaseModel {
    * @param[in] gpu_rank The GPU rank. Default is 0.
    * @param[in] file_content The content of the model file. If it is not empty,
    *DP will read from the string instead of the file.
+   * @param[in] nthreads The number of threads used by this DP. If it is
+   *positive, it overrides the environment variables of the parallelism.
+   *Default is 0.
    **/
   DeepPot(const std::string& model,
           const int& gpu_rank = 0,
-          const std::string& file_content = "");
+          const std::string& file_content = "",
+          const int& nthreads = 0);
   /**
    * @brief Initialize the DP.
    * @param[in] model The name of the frozen model file.
    * @param[in] gpu_rank The GPU rank. Default is 0.
    * @param[in] file_content The content of the model file. If it is not empty,
    *DP will read from the string instead of the file.
+   * @param[in] nthreads The number of threads used by this DP. If it is
+   *positive, it overrides the environment variables of the parallelism.
+   *Default is 0.
    **/
   void init(const std::string& model,
             const int& gpu_rank = 0,
-            const std::string& file_content = "");
+            const std::string& file_content = "",
+            const int& nthreads = 0);
 
   /**
    * @brief Evaluate the energy, force and virial by using this DP.
@@ -420,6 +484,50 @@ class DeepPot : public DeepBaseModel {
                const std::vector<VALUETYPE>& fparam = std::vector<VALUETYPE>(),
                const std::vector<VALUETYPE>& aparam = std::vector<VALUETYPE>());
   /** @} */
+  /**
+   * @brief Evaluate the energy, force, virial, atomic energy, and atomic virial
+   *by using this DP, writing the results directly into caller-provided
+   *buffers.
+   * @details This avoids the intermediate vectors of the overloads above. If
+   *the backend supports it, the output tensors are copied only once into the
+   *buffers.
+   * @param[out] ener The system energy.
+   * @param[out] force The force on each atom. The buffer should be of size
+   *natoms x 3.
+   * @param[out] virial The virial. The buffer should be of size 9. If it is
+   *nullptr, the virial is not computed when the backend supports it, e.g. for
+   *NVT simulations without pressure output.
+   * @param[out] atom_energy The atomic energy. The buffer should be of size
+   *natoms. If atom_energy or atom_virial is nullptr, the atomic energy and
+   *virial are not computed.
+   * @param[out] atom_virial The atomic virial. The buffer should be of size
+   *natoms x 9.
+   * @param[in] coord The coordinates of atoms. The array should be of size
+   *natoms x 3.
+   * @param[in] atype The atom types. The list should contain natoms ints.
+   * @param[in] box The cell of the region. The array should be of size 9.
+   * @param[in] nghost The number of ghost atoms.
+   * @param[in] lmp_list The input neighbour list.
+   * @param[in] ago Update the internal neighbour list if ago is 0.
+   * @param[in] fparam The frame parameter. The array can be of size
+   *dim_fparam.
+   * @param[in] aparam The atomic parameter The array can be of size
+   *natoms x dim_aparam.
+   **/
+  template <typename VALUETYPE>
+  void compute(ENERGYTYPE& ener,
+               VALUETYPE* force,
+               VALUETYPE* virial,
+               VALUETYPE* atom_energy,
+               VALUETYPE* atom_virial,
+               const std::vector<VALUETYPE>& coord,
+               const std::vector<int>& atype,
+               const std::vector<VALUETYPE>& box,
+               const int nghost,
+               const InputNlist& lmp_list,
+               const int& ago,
+               const std::vector<VALUETYPE>& fparam = std::vector<VALUETYPE>(),
+               const std::vector<VALUETYPE>& aparam = std::vector<VALUETYPE>());
   /**
    * @brief Evaluate the energy, force, and virial with the mixed type
    *by using this DP.
@@ -535,22 +643,30 @@ class DeepPotModelDevi : public DeepBaseModelDevi {
    * @param[in] gpu_rank The GPU rank. Default is 0.
    * @param[in] file_contents The contents of the model files. If it is not
    *empty, DP will read from the strings instead of the files.
+   * @param[in] nthreads The number of threads used by each model. If it is
+   *positive, it overrides the environment variables of the parallelism.
+   *Default is 0.
    **/
   DeepPotModelDevi(const std::vector<std::string>& models,
                    const int& gpu_rank = 0,
                    const std::vector<std::string>& file_contents =
-                       std::vector<std::string>());
+                       std::vector<std::string>(),
+                   const int& nthreads = 0);
   /**
    * @brief Initialize the DP model deviation contrcutor.
    * @param[in] models The names of the frozen model files.
    * @param[in] gpu_rank The GPU rank. Default is 0.
    * @param[in] file_contents The contents of the model files. If it is not
    *empty, DP will read from the strings instead of the files.
+   * @param[in] nthreads The number of threads used by each model. If it is
+   *positive, it overrides the environment variables of the parallelism.
+   *Default is 0.
    **/
   void init(const std::vector<std::string>& models,
             const int& gpu_rank = 0,
             const std::vector<std::string>& file_contents =
-                std::vector<std::string>());
+                std::vector<std::string>(),
+            const int& nthreads = 0);
 
   /**
    * @brief Evaluate the energy, force and virial by using these DP models.
@@ -4,6 +4,8 @@
 #include <tensorflow/c/c_api.h>
 #include <tensorflow/c/eager/c_api.h>
 
+#include <map>
+
 #include "DeepPot.h"
 #include "common.h"
 #include "neighbor_list.h"
@@ -191,10 +193,8 @@ class DeepPotJAX : public DeepPotBackend {
   int nnei;
   // do message passing
   bool do_message_passing;
-  // padding to nall
-  int padding_to_nall = 0;
-  // padding for nloc
-  int padding_for_nloc = 0;
+  // padding of nloc, nall, and nnei
+  ShapeBucketing shape_bucketing;
   /**  TF C API objects.
    * @{
    */
@@ -205,6 +205,10 @@ class DeepPotJAX : public DeepPotBackend {
   TFE_ContextOptions* ctx_opts;
   TFE_Context* ctx;
   std::vector<TF_Function*> func_vector;
+  // function ops kept between calls, which are reset before each execution
+  std::map<std::string, TFE_Op*> func_ops;
+  // input tensors of call_lower kept between calls, written in place
+  std::vector<TF_Tensor*> lower_inputs;
   /**
    * @}
    */
@@ -3,6 +3,8 @@
 
 #include <paddle/include/paddle_inference_api.h>
 
+#include <mutex>
+
 #include "DeepPot.h"
 
 namespace deepmd {
@@ -392,6 +394,40 @@ class DeepPotPD : public DeepPotBackend {
   int do_message_passing;  // 1:dpa2 model 0:others
   bool gpu_enabled;
   std::unique_ptr<paddle_infer::Tensor> firstneigh_tensor;
+  // flattened neighbor list, updated when the neighbor list is rebuilt
+  std::vector<int> firstneigh;
+  // idle predictors for model.forward; a clone of predictor, which shares
+  // the weights, is added when all of them are in use by concurrent callers
+  std::vector<std::shared_ptr<paddle_infer::Predictor>> predictor_pool;
+  std::mutex predictor_pool_mutex;
+  /**
+   * @brief Take an idle predictor for model.forward from the pool.
+   * @return The predictor, which should be given back by release_predictor.
+   * Use PredictorGuard instead of calling it directly.
+   **/
+  std::shared_ptr<paddle_infer::Predictor> acquire_predictor();
+  /**
+   * @brief Give a predictor back to the pool.
+   * @param[in] pred The predictor taken by acquire_predictor.
+   **/
+  void release_predictor(std::shared_ptr<paddle_infer::Predictor> pred);
+  /**
+   * @brief A predictor taken from the pool, which is given back when the
+   * guard goes out of scope, including when an exception is thrown.
+   **/
+  class PredictorGuard {
+   public:
+    explicit PredictorGuard(DeepPotPD& dp_)
+        : dp(dp_), pred(dp_.acquire_predictor()) {};
+    ~PredictorGuard() { dp.release_predictor(pred); };
+    PredictorGuard(const PredictorGuard&) = delete;
+    PredictorGuard& operator=(const PredictorGuard&) = delete;
+    paddle_infer::Predictor* operator->() const { return pred.get(); };
+
+   private:
+    DeepPotPD& dp;
+    std::shared_ptr<paddle_infer::Predictor> pred;
+  };
   // std::unordered_map<std::string, paddle::Tensor> comm_dict; # Not used yet
 };
 
@@ -4,7 +4,10 @@
 #include <torch/script.h>
 #include <torch/torch.h>
 
+#include <array>
+
 #include "DeepPot.h"
+#include "commonPT.h"
 
 namespace deepmd {
 /**
@@ -115,6 +118,43 @@ class DeepPotPT : public DeepPotBackend {
                const std::vector<VALUETYPE>& fparam,
                const std::vector<VALUETYPE>& aparam,
                const bool atomic);
+  /**
+   * @brief Evaluate the energy, force, virial, atomic energy, and atomic virial
+   *by using this DP, writing the results into caller-provided buffers.
+   * @param[out] ener The system energy.
+   * @param[out] force The force on each atom. The buffer should be of size
+   *natoms x 3.
+   * @param[out] virial The virial. The buffer should be of size 9.
+   * @param[out] atom_energy The atomic energy. The buffer should be of size
+   *natoms. Not referenced if atomic is false.
+   * @param[out] atom_virial The atomic virial. The buffer should be of size
+   *natoms x 9. Not referenced if atomic is false.
+   * @param[in] coord The coordinates of atoms. The array should be of size
+   *natoms x 3.
+   * @param[in] atype The atom types. The list should contain natoms ints.
+   * @param[in] box The cell of the region. The array should be of size 9.
+   * @param[in] nghost The number of ghost atoms.
+   * @param[in] lmp_list The input neighbour list.
+   * @param[in] ago Update the internal neighbour list if ago is 0.
+   * @param[in] fparam The frame parameter.
+   * @param[in] aparam The atomic parameter.
+   * @param[in] atomic Whether to compute the atomic energy and virial.
+   **/
+  template <typename VALUETYPE, typename ENERGYVTYPE>
+  void compute(ENERGYVTYPE& ener,
+               VALUETYPE* force,
+               VALUETYPE* virial,
+               VALUETYPE* atom_energy,
+               VALUETYPE* atom_virial,
+               const std::vector<VALUETYPE>& coord,
+               const std::vector<int>& atype,
+               const std::vector<VALUETYPE>& box,
+               const int nghost,
+               const InputNlist& lmp_list,
+               const int& ago,
+               const std::vector<VALUETYPE>& fparam,
+               const std::vector<VALUETYPE>& aparam,
+               const bool atomic);
   /**
    * @brief Evaluate the energy, force, and virial with the mixed type
    *by using this DP.
@@ -229,6 +269,26 @@ class DeepPotPT : public DeepPotBackend {
     assert(inited);
     return daparam;
   };
+  /**
+   * @brief Warm up the model over representative shapes.
+   * @details TorchScript specializes and fuses the graph for each new shape
+   *during the first runs. Running the model over the shapes expected in
+   *production moves this cost before the first MD step. The shapes are run at
+   *the next evaluation that rebuilds the neighbor list, through the same path
+   *as that evaluation, so the precision, the mapping, and the shape buckets
+   *match the actual calls. Message passing models are run without exchanging
+   *the features of ghost atoms. The warm-up shapes are also read from the
+   *environment variable DP_PT_WARMUP_SHAPES in init.
+   * @param[in] shapes The list of (nloc, nall, nnei).
+   **/
+  void warmup(const std::vector<std::array<int, 3>>& shapes);
+  /**
+   * @brief Get the shapes that the model has been warmed up with.
+   * @return The list of (nloc, nall, nnei).
+   **/
+  const std::vector<std::array<int, 3>>& get_warmup_shapes() const {
+    return warmup_shapes;
+  };
   /**
    * @brief Get the type map (element name of the atom types) of this model.
    * @param[out] type_map The type map of this model.
@@ -296,6 +356,34 @@ class DeepPotPT : public DeepPotBackend {
                 const std::vector<float>& fparam,
                 const std::vector<float>& aparam,
                 const bool atomic);
+  void computew_buffer(std::vector<double>& ener,
+                       double* force,
+                       double* virial,
+                       double* atom_energy,
+                       double* atom_virial,
+                       const std::vector<double>& coord,
+                       const std::vector<int>& atype,
+                       const std::vector<double>& box,
+                       const int nghost,
+                       const InputNlist& inlist,
+                       const int& ago,
+                       const std::vector<double>& fparam,
+                       const std::vector<double>& aparam,
+                       const bool atomic);
+  void computew_buffer(std::vector<double>& ener,
+                       float* force,
+                       float* virial,
+                       float* atom_energy,
+                       float* atom_virial,
+                       const std::vector<float>& coord,
+                       const std::vector<int>& atype,
+                       const std::vector<float>& box,
+                       const int nghost,
+                       const InputNlist& inlist,
+                       const int& ago,
+                       const std::vector<float>& fparam,
+                       const std::vector<float>& aparam,
+                       const bool atomic);
   void computew_mixed_type(std::vector<double>& ener,
                            std::vector<double>& force,
                            std::vector<double>& virial,
@@ -322,6 +410,11 @@ class DeepPotPT : public DeepPotBackend {
                            const bool atomic);
 
  private:
+  /**
+   * @brief Set the number of intra-op threads of PyTorch to the one of this
+   * model if they differ.
+   **/
+  void apply_nthreads();
   int num_intra_nthreads, num_inter_nthreads;
   bool inited;
   int ntypes;
@@ -340,6 +433,35 @@ class DeepPotPT : public DeepPotBackend {
   at::Tensor firstneigh_tensor;
   c10::optional<torch::Tensor> mapping_tensor;
   torch::Dict<std::string, torch::Tensor> comm_dict;
+  // shapes that have been specialized by warmup
+  std::vector<std::array<int, 3>> warmup_shapes;
+  // shapes to warm up at the next rebuild of the neighbor list
+  std::vector<std::array<int, 3>> pending_warmup_shapes;
+  // the width the neighbor list is padded to while warming up
+  int warmup_nnei = 0;
+  /**
+   * @brief Run the pending warm-up shapes.
+   * @tparam VALUETYPE The float type of the actual evaluation.
+   * @param[in] lmp_list The neighbor list of the actual evaluation, which
+   *tells whether the mapping and the communicator are given.
+   **/
+  template <typename VALUETYPE>
+  void run_warmup(const InputNlist& lmp_list);
+  // pad the inputs to buckets to reduce respecializations
+  bool shape_bucketing_enabled;
+  ShapeBucketing shape_bucketing;
+  // reusable input buffers
+  TorchInputWorkspace<double> workspace_double;
+  TorchInputWorkspace<float> workspace_float;
+  TorchInputBuffer<std::int64_t> nlist_buffer;
+  TorchInputBuffer<std::int64_t> mapping_buffer;
+  /**
+   * @brief Get the input workspace of the given precision.
+   * @tparam VALUETYPE The float type of the inputs.
+   * @return The input workspace.
+   */
+  template <typename VALUETYPE>
+  TorchInputWorkspace<VALUETYPE>& workspace();
   /**
    * @brief Translate PyTorch exceptions to the DeePMD-kit exception.
    * @param[in] f The function to run.
@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 #pragma once
 
+#include <memory>
+
 #include "DeepPot.h"
 #include "common.h"
 #include "commonTF.h"
@@ -99,6 +101,8 @@ class DeepPotTF : public DeepPotBackend {
    * natoms x dim_aparam. Then all frames are assumed to be provided with the
    *same aparam.
    * @param[in] atomic Whether to compute atomic energy and virial.
+   * @param[in] need_virial Whether to compute the virial. If false, the
+   *virial is set to zero and the virial nodes are not evaluated.
    **/
   template <typename VALUETYPE, typename ENERGYVTYPE>
   void compute(ENERGYVTYPE& ener,
@@ -114,7 +118,8 @@ class DeepPotTF : public DeepPotBackend {
                const int& ago,
                const std::vector<VALUETYPE>& fparam,
                const std::vector<VALUETYPE>& aparam,
-               const bool atomic);
+               const bool atomic,
+               const bool need_virial = true);
   /**
    * @brief Evaluate the energy, force, and virial with the mixed type
    *by using this DP.
@@ -262,6 +267,34 @@ class DeepPotTF : public DeepPotBackend {
                 const std::vector<float>& fparam,
                 const std::vector<float>& aparam,
                 const bool atomic);
+  void computew_buffer(std::vector<double>& ener,
+                       double* force,
+                       double* virial,
+                       double* atom_energy,
+                       double* atom_virial,
+                       const std::vector<double>& coord,
+                       const std::vector<int>& atype,
+                       const std::vector<double>& box,
+                       const int nghost,
+                       const InputNlist& inlist,
+                       const int& ago,
+                       const std::vector<double>& fparam,
+                       const std::vector<double>& aparam,
+                       const bool atomic);
+  void computew_buffer(std::vector<double>& ener,
+                       float* force,
+                       float* virial,
+                       float* atom_energy,
+                       float* atom_virial,
+                       const std::vector<float>& coord,
+                       const std::vector<int>& atype,
+                       const std::vector<float>& box,
+                       const int nghost,
+                       const InputNlist& inlist,
+                       const int& ago,
+                       const std::vector<float>& fparam,
+                       const std::vector<float>& aparam,
+                       const bool atomic);
   void computew_mixed_type(std::vector<double>& ener,
                            std::vector<double>& force,
                            std::vector<double>& virial,
@@ -289,8 +322,12 @@ class DeepPotTF : public DeepPotBackend {
 
  private:
   tensorflow::Session* session;
+  SessionCallables callables;
   int num_intra_nthreads, num_inter_nthreads;
   tensorflow::GraphDef* graph_def;
+  // the environment mapping the constants of a memmapped model, which should
+  // live as long as the session
+  std::unique_ptr<tensorflow::Env> model_env;
   bool inited;
   template <class VT>
   VT get_scalar(const std::string& name) const;
@@ -332,12 +369,23 @@ class DeepPotTF : public DeepPotBackend {
                           const int& nframes,
                           const int& dparam,
                           const std::vector<VALUETYPE>& param) const;
+  /**
+   * @brief Update the atom map that sorts the atoms by types.
+   * @details The atom map is only rebuilt if the types are different from
+   * those of the last call, since the types rarely change between steps.
+   * @param[in] type_begin The begin of the atom types.
+   * @param[in] type_end The end of the atom types.
+   */
+  void update_atommap(const std::vector<int>::const_iterator type_begin,
+                      const std::vector<int>::const_iterator type_end);
   // copy neighbor list info from host
   bool init_nbor;
   std::vector<int> sec_a;
   NeighborListData nlist_data;
   InputNlist nlist;
   AtomMap atommap;
+  // the unsorted types that atommap is built from
+  std::vector<int> atommap_type;
 };
 
 }  // namespace deepmd
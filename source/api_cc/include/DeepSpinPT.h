@@ -5,6 +5,7 @@
 #include <torch/torch.h>
 
 #include "DeepSpin.h"
+#include "commonPT.h"
 
 namespace deepmd {
 /**
@@ -262,6 +263,17 @@ class DeepSpinPT : public DeepSpinBackend {
   at::Tensor firstneigh_tensor;
   c10::optional<torch::Tensor> mapping_tensor;
   torch::Dict<std::string, torch::Tensor> comm_dict;
+  // reusable input buffers
+  TorchInputWorkspace<double> workspace_double;
+  TorchInputWorkspace<float> workspace_float;
+  TorchInputBuffer<std::int64_t> nlist_buffer;
+  /**
+   * @brief Get the input workspace of the given precision.
+   * @tparam VALUETYPE The float type of the inputs.
+   * @return The input workspace.
+   */
+  template <typename VALUETYPE>
+  TorchInputWorkspace<VALUETYPE>& workspace();
   /**
    * @brief Translate PyTorch exceptions to the DeePMD-kit exception.
    * @param[in] f The function to run.
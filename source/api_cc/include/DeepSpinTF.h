@@ -267,6 +267,7 @@ class DeepSpinTF : public DeepSpinBackend {
 
  private:
   tensorflow::Session* session;
+  SessionCallables callables;
   int num_intra_nthreads, num_inter_nthreads;
   tensorflow::GraphDef* graph_def;
   bool inited;
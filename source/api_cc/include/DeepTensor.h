@@ -179,7 +179,8 @@ class DeepTensor {
   void print_summary(const std::string& pre) const;
 
   /**
-   * @brief Evaluate the value by using this model.
+   * @brief Evaluate the value by using this model. Only the forward pass is
+   *run, without the derivatives of the tensor.
    * @param[out] value The value to evaluate, usually would be the atomic
    *tensor.
    * @param[in] coord The coordinates of atoms. The array should be of size
@@ -193,7 +194,8 @@ class DeepTensor {
                const std::vector<int>& atype,
                const std::vector<VALUETYPE>& box);
   /**
-   * @brief Evaluate the value by using this model.
+   * @brief Evaluate the value by using this model. Only the forward pass is
+   *run, without the derivatives of the tensor.
    * @param[out] value The value to evaluate, usually would be the atomic
    *tensor.
    * @param[in] coord The coordinates of atoms. The array should be of size
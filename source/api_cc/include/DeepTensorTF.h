@@ -248,6 +248,7 @@ class DeepTensorTF : public DeepTensorBase {
 
  private:
   tensorflow::Session* session;
+  SessionCallables callables;
   std::string name_scope;
   int num_intra_nthreads, num_inter_nthreads;
   tensorflow::GraphDef* graph_def;
@@ -266,7 +267,7 @@ class DeepTensorTF : public DeepTensorBase {
   void get_vector(std::vector<VT>& vec, const std::string& name) const;
   template <typename MODELTYPE, typename VALUETYPE>
   void run_model(std::vector<VALUETYPE>& d_tensor_,
-                 tensorflow::Session* session,
+                 SessionCallables& callables,
                  const std::vector<std::pair<std::string, tensorflow::Tensor>>&
                      input_tensors,
                  const AtomMap& atommap,
@@ -278,7 +279,7 @@ class DeepTensorTF : public DeepTensorBase {
                  std::vector<VALUETYPE>& dvirial_,
                  std::vector<VALUETYPE>& datom_tensor_,
                  std::vector<VALUETYPE>& datom_virial_,
-                 tensorflow::Session* session,
+                 SessionCallables& callables,
                  const std::vector<std::pair<std::string, tensorflow::Tensor>>&
                      input_tensors,
                  const AtomMap& atommap,
@@ -1,8 +1,10 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 #pragma once
 
+#include <chrono>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "AtomMap.h"
@@ -22,6 +24,23 @@ enum DPBackend { TensorFlow, PyTorch, Paddle, JAX, Unknown };
  **/
 DPBackend get_backend(const std::string& model);
 
+/**
+ * @brief Check whether the model is a memmapped TensorFlow package, whose
+ * constants are mapped from the file instead of being read into memory.
+ * @param[in] model The model name.
+ * @return Whether the model name ends with .pbmm.
+ **/
+bool is_memmapped_model(const std::string& model);
+
+/**
+ * @brief Throw an exception if the model is a memmapped TensorFlow package,
+ * which can only be loaded by DeepPot.
+ * @param[in] model The model name.
+ * @param[in] class_name The name of the class loading the model.
+ **/
+void reject_memmapped_model(const std::string& model,
+                            const std::string& class_name);
+
 struct NeighborListData {
   /// Array stores the core region atom's index
   std::vector<int> ilist;
@@ -44,7 +63,87 @@ struct NeighborListData {
   void shuffle(const deepmd::AtomMap& map);
   void shuffle_exclude_empty(const std::vector<int>& fwd_map);
   void make_inlist(InputNlist& inlist);
-  void padding();
+  void padding(const size_t min_length = 0);
+};
+
+/**
+ * @brief Bucketing policy for the shape of the extended system.
+ * @details The number of local atoms, the number of all atoms, and the number
+ * of neighbors change slightly between neighbor list rebuilds. Each new shape
+ * causes a retrace of a XLA function or invalidates the fused kernels of a
+ * TorchScript model. The shapes are thus padded to buckets which grow
+ * geometrically by the padding factor, and a bucket is kept until the actual
+ * size goes over it or falls much below it. Padding atoms have the type -1 and
+ * are masked by the model.
+ *
+ * The padded layout of the extended system is
+ * [nloc real atoms, padding local atoms, nghost real atoms, padding atoms].
+ */
+class ShapeBucketing {
+ public:
+  /**
+   * @brief Constructor.
+   * @param[in] factor The padding factor, which should be larger than 1.
+   */
+  explicit ShapeBucketing(const double factor = 1.05) : factor(factor) {};
+  /**
+   * @brief Update the buckets by the actual shape.
+   * @param[in] nloc The number of local atoms.
+   * @param[in] nall The number of all atoms.
+   * @param[in] nnei The number of neighbors.
+   * @param[in] pad_atoms Whether to pad nloc and nall. If false, only nnei is
+   * padded, which is required when the layout of atoms can not be changed,
+   * e.g. for message passing across MPI ranks.
+   */
+  void update(const int nloc,
+              const int nall,
+              const int nnei,
+              const bool pad_atoms = true);
+  /**
+   * @brief Get the index of an atom in the padded layout.
+   * @param[in] ii The index of the atom in the actual layout.
+   * @return The index in the padded layout.
+   */
+  int padded_index(const int ii) const {
+    return ii < nloc ? ii : ii + nloc_padded - nloc;
+  };
+  /**
+   * @brief Get the number of shape changes of the actual system.
+   */
+  int num_shape_changes() const { return nshape_changes; };
+  /**
+   * @brief Get the number of changes of the padded shape, i.e. the
+   * number of recompilations.
+   */
+  int num_bucket_changes() const { return nbucket_changes; };
+  /**
+   * @brief Get the number of recompilations avoided by bucketing.
+   */
+  int num_avoided() const { return nshape_changes - nbucket_changes; };
+  /// Actual number of local atoms.
+  int nloc = 0;
+  /// Actual number of all atoms.
+  int nall = 0;
+  /// Actual number of neighbors.
+  int nnei = 0;
+  /// Padded number of local atoms.
+  int nloc_padded = 0;
+  /// Padded number of all atoms.
+  int nall_padded = 0;
+  /// Padded number of neighbors.
+  int nnei_padded = 0;
+
+ private:
+  double factor;
+  int nshape_changes = 0;
+  int nbucket_changes = 0;
+  /**
+   * @brief Get the padded size of a dimension.
+   * @param[in] n The actual size.
+   * @param[in] padded The current padded size.
+   * @return The new padded size.
+   */
+  int pad(const int n, const int padded) const;
 };
 
 /**
@@ -153,9 +252,32 @@ void select_map_inv(typename std::vector<VT>::iterator out,
                     const std::vector<int>& fwd_map,
                     const int& stride);
 
+/**
+ * @brief Override the number of threads given by get_env_nthreads in the
+ * current thread while the object is alive.
+ * @details A model initialized in this scope uses nthreads intra-op threads
+ * and a single inter-op thread, so that several models, or several MPI ranks
+ * on a node, can share the node without oversubscription.
+ **/
+class ScopedThreadBudget {
+ public:
+  /**
+   * @brief Set the thread budget of the current thread.
+   * @param[in] nthreads The number of threads. If it is not positive, the
+   * environment variables are used.
+   **/
+  explicit ScopedThreadBudget(const int nthreads);
+  ~ScopedThreadBudget();
+
+ private:
+  int last_nthreads;
+};
+
 /**
  * @brief Get the number of threads from the environment variable.
  * @details A warning will be thrown if environment variables are not set.
+ * The environment variables are not read if a ScopedThreadBudget is alive in
+ * the current thread.
  * @param[out] num_intra_nthreads The number of intra threads. Read from
  *DP_INTRA_OP_PARALLELISM_THREADS.
  * @param[out] num_inter_nthreads The number of inter threads. Read from
@@ -166,8 +288,53 @@ void get_env_nthreads(int& num_intra_nthreads, int& num_inter_nthreads);
 /**
  * @brief Dynamically load OP library. This should be called before loading
  * graphs.
+ * @details Only the OP library of the given backend and the plugins in
+ * DP_PLUGIN_PATH are loaded. Each library is loaded once in the process.
+ * @param[in] backend The backend of the model. The OP libraries of all built
+ * backends are loaded if it is Unknown.
+ */
+void load_op_library(const DPBackend& backend = DPBackend::Unknown);
+
+/**
+ * @brief Dynamically load the plugins in DP_PLUGIN_PATH, without any OP
+ * library of the backends.
+ * @details Each plugin is loaded once in the process.
  */
-void load_op_library();
+void load_plugin_library();
+
+/**
+ * @brief Check whether this process is the first MPI rank.
+ * @details The rank is read from the environment variables set by common MPI
+ * launchers (Open MPI, MPICH, Intel MPI, MVAPICH, and Slurm), as the C++
+ * interface does not depend on MPI. A process without any of them is the
+ * first rank.
+ * @return Whether the rank is 0.
+ **/
+bool is_first_rank();
+
+/**
+ * @brief Timer of the steps to initialize a model.
+ **/
+class InitTimer {
+ public:
+  InitTimer();
+  /**
+   * @brief Record the time since the last record as a step.
+   * @param[in] step The name of the step.
+   **/
+  void record(const std::string& step);
+  /**
+   * @brief Print the total time and the time of each step.
+   * @details Nothing is printed unless the environment variable DP_INIT_TIMING
+   * is set, or by ranks other than the first one.
+   * @param[in] model The name of the model.
+   **/
+  void report(const std::string& model) const;
+
+ private:
+  std::chrono::steady_clock::time_point start, last;
+  std::vector<std::pair<std::string, double>> steps;
+};
 
 /** @struct deepmd::deepmd_exception
  **/
@@ -184,6 +351,23 @@ struct tf_exception : public deepmd::deepmd_exception {
 
 std::string name_prefix(const std::string& name_scope);
 
+/**
+ * @brief Bind the calling thread to the cores assigned to a rank on a node.
+ * @details The cores available to the process are split into node_nranks
+ *contiguous blocks, and the block of node_rank is used. The existing OpenMP
+ *threads are bound to the same block, and the thread pools of the backends
+ *created afterwards inherit the binding, so the memory they first touch is
+ *allocated on the local NUMA node. The cores available to the process are
+ *those given by sched_getaffinity, which respects cpusets and cgroups. The
+ *caller should not use it if the MPI launcher has already bound the ranks.
+ *Nothing is done if there are fewer cores than ranks, or on platforms other
+ *than Linux.
+ * @param[in] node_rank The rank on the node.
+ * @param[in] node_nranks The number of ranks on the node.
+ * @return The number of bound cores, or 0 if nothing is done.
+ **/
+int bind_node_cores(const int& node_rank, const int& node_nranks);
+
 /**
  * @brief Read model file to a string.
  * @param[in] model Path to the model.
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+#pragma once
+
+#include <torch/torch.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace deepmd {
+/**
+ * @brief A reusable input buffer of a PyTorch model.
+ * @details The buffer keeps a host tensor, which is pinned if the target
+ * device is a GPU, and a device tensor. Both grow geometrically and are
+ * reused across calls, so that no memory is allocated in the steady state.
+ * @tparam T The element type of the tensor.
+ **/
+template <typename T>
+class TorchInputBuffer {
+ public:
+  /**
+   * @brief Get the host memory to fill the next input.
+   * @param[in] numel The number of elements.
+   * @param[in] device The device of the model.
+   * @return The pointer to the host memory with at least numel elements.
+   **/
+  T* host(const int64_t numel, const torch::Device& device) {
+    reserve(numel, device);
+    numel_ = numel;
+    return host_.data_ptr<T>();
+  }
+  /**
+   * @brief Copy the filled host memory to the device.
+   * @param[in] sizes The shape of the input tensor.
+   * @return The input tensor on the device, which is a view of the buffer.
+   **/
+  torch::Tensor to_device(at::IntArrayRef sizes) {
+    torch::Tensor dst = device_.narrow(0, 0, numel_);
+    if (device_.data_ptr() != host_.data_ptr()) {
+      // the host buffer is pinned, so the copy can be asynchronous
+      dst.copy_(host_.narrow(0, 0, numel_), true);
+    }
+    return dst.view(sizes);
+  }
+  /**
+   * @brief Copy data to the device, converting the data type if needed.
+   * @param[in] data The data on the host.
+   * @param[in] sizes The shape of the input tensor.
+   * @param[in] device The device of the model.
+   * @return The input tensor on the device, which is a view of the buffer.
+   **/
+  template <typename FROM>
+  torch::Tensor copy_from(const FROM* data,
+                          at::IntArrayRef sizes,
+                          const torch::Device& device) {
+    int64_t numel = 1;
+    for (const int64_t size : sizes) {
+      numel *= size;
+    }
+    T* dst = host(numel, device);
+    std::copy(data, data + numel, dst);
+    return to_device(sizes);
+  }
+  /**
+   * @brief Flatten a padded neighbor list to the device.
+   * @param[in] jlist The neighbor list, each row of which has the same size.
+   * @param[in] device The device of the model.
+   * @return The neighbor list tensor of shape 1 x nloc x nnei on the device.
+   **/
+  torch::Tensor copy_from_nlist(const std::vector<std::vector<int>>& jlist,
+                                const torch::Device& device) {
+    const int64_t nloc = jlist.size();
+    const int64_t nnei = nloc > 0 ? jlist[0].size() : 0;
+    T* dst = host(nloc * nnei, device);
+    for (const auto& row : jlist) {
+      dst = std::copy(row.begin(), row.end(), dst);
+    }
+    return to_device({1, nloc, nnei});
+  }
+
+ private:
+  torch::Tensor host_;
+  torch::Tensor device_;
+  int64_t capacity_ = 0;
+  int64_t numel_ = 0;
+  void reserve(const int64_t numel, const torch::Device& device) {
+    if (device_.defined() && numel <= capacity_ &&
+        device_.device() == device) {
+      return;
+    }
+    capacity_ = std::max(numel, capacity_ * 2);
+    auto options = torch::dtype<T>();
+    if (device.is_cpu()) {
+      host_ = torch::empty({capacity_}, options);
+      device_ = host_;
+    } else {
+      host_ = torch::empty({capacity_}, options.pinned_memory(true));
+      device_ = torch::empty({capacity_}, options.device(device));
+    }
+  }
+};
+
+/**
+ * @brief The reusable per-step input buffers of a PyTorch model.
+ * @details The neighbor list and the mapping are only updated when the
+ * neighbor list is rebuilt, so they are not part of the workspace.
+ * @tparam VALUETYPE The float type of the inputs.
+ **/
+template <typename VALUETYPE>
+struct TorchInputWorkspace {
+  TorchInputBuffer<VALUETYPE> coord;
+  TorchInputBuffer<VALUETYPE> spin;
+  TorchInputBuffer<VALUETYPE> box;
+  TorchInputBuffer<VALUETYPE> fparam;
+  TorchInputBuffer<VALUETYPE> aparam;
+  TorchInputBuffer<std::int64_t> atype;
+};
+}  // namespace deepmd
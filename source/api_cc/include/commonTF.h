@@ -1,5 +1,9 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
+#pragma once
+
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #ifdef TF_PRIVATE
@@ -15,6 +19,54 @@ namespace deepmd {
  **/
 void check_status(const tensorflow::Status& status);
 
+/**
+ * @brief Check whether a graph uses OPs that have not been registered, so that
+ * the OP library should be loaded before the graph is imported.
+ * @param[in] graph_def The graph.
+ * @return Whether any OP in the graph has not been registered.
+ **/
+bool has_unregistered_ops(const tensorflow::GraphDef& graph_def);
+
+/**
+ * @brief Callables of a TensorFlow session.
+ * @details Session::Run resolves the names of feeds and fetches and prepares
+ * the executors on every call. A callable is instead created once for each
+ * signature of feeds and fetches and reused by the later runs.
+ **/
+class SessionCallables {
+ public:
+  SessionCallables() : session(nullptr) {};
+  ~SessionCallables();
+  SessionCallables(const SessionCallables&) = delete;
+  SessionCallables& operator=(const SessionCallables&) = delete;
+  /**
+   * @brief Set the session to run. Callables of the previous session are
+   * released.
+   * @param[in] session TensorFlow session.
+   **/
+  void reset(tensorflow::Session* session);
+  /**
+   * @brief Run the session by the callable of the feeds and fetches.
+   * @param[in] input_tensors The named input tensors.
+   * @param[in] output_names The names of the output tensors.
+   * @param[out] output_tensors The output tensors.
+   **/
+  void run(const std::vector<std::pair<std::string, tensorflow::Tensor>>&
+               input_tensors,
+           const std::vector<std::string>& output_names,
+           std::vector<tensorflow::Tensor>* output_tensors);
+
+ private:
+  /**
+   * @brief Release the callables created in the session.
+   **/
+  void release();
+  tensorflow::Session* session;
+  // the callable handle of each signature, or -1 if callables are not
+  // supported by the session
+  std::unordered_map<std::string, std::int64_t> handles;
+};
+
 /**
  * @brief Get the value of a tensor.
  * @param[in] session TensorFlow session.
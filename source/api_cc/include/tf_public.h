@@ -9,6 +9,7 @@
 // skip if TF headers have been included
 #ifndef TF_MAJOR_VERSION
 namespace tensorflow {
+class Env;
 class Session;
 class Tensor;
 class GraphDef;
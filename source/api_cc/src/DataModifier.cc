@@ -30,6 +30,7 @@ void DipoleChargeModifier::init(const std::string& model,
   }
   const DPBackend backend = get_backend(model);
   if (deepmd::DPBackend::TensorFlow == backend) {
+    reject_memmapped_model(model, "DipoleChargeModifier");
 #ifdef BUILD_TENSORFLOW
     dcm = std::make_shared<deepmd::DipoleChargeModifierTF>(model, gpu_rank,
                                                            name_scope_);
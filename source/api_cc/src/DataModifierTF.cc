@@ -39,7 +39,7 @@ void DipoleChargeModifierTF::init(const std::string& model,
   get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
   options.config.set_inter_op_parallelism_threads(num_inter_nthreads);
   options.config.set_intra_op_parallelism_threads(num_intra_nthreads);
-  deepmd::load_op_library();
+  deepmd::load_op_library(DPBackend::TensorFlow);
   int gpu_num = -1;
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
   DPGetDeviceCount(gpu_num);  // check current device environment
@@ -60,6 +60,7 @@ void DipoleChargeModifierTF::init(const std::string& model,
   deepmd::check_status(NewSession(options, &session));
   deepmd::check_status(ReadBinaryProto(Env::Default(), model, graph_def));
   deepmd::check_status(session->Create(*graph_def));
+  callables.reset(session);
   dtype = session_get_dtype(session, "descrpt_attr/rcut");
   if (dtype == tensorflow::DT_DOUBLE) {
     rcut = get_scalar<double>("descrpt_attr/rcut");
@@ -89,7 +90,7 @@ template <typename MODELTYPE, typename VALUETYPE>
 void DipoleChargeModifierTF::run_model(
     std::vector<VALUETYPE>& dforce,
     std::vector<VALUETYPE>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nghost) {
@@ -102,9 +103,8 @@ void DipoleChargeModifierTF::run_model(
   }
 
   std::vector<Tensor> output_tensors;
-  deepmd::check_status(session->Run(input_tensors,
-                                    {"o_dm_force", "o_dm_virial", "o_dm_av"},
-                                    {}, &output_tensors));
+  callables.run(input_tensors, {"o_dm_force", "o_dm_virial", "o_dm_av"},
+                &output_tensors);
   int cc = 0;
   Tensor output_f = output_tensors[cc++];
   Tensor output_v = output_tensors[cc++];
@@ -138,7 +138,7 @@ void DipoleChargeModifierTF::run_model(
 template void DipoleChargeModifierTF::run_model<double, double>(
     std::vector<double>& dforce,
     std::vector<double>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nghost);
@@ -146,7 +146,7 @@ template void DipoleChargeModifierTF::run_model<double, double>(
 template void DipoleChargeModifierTF::run_model<float, double>(
     std::vector<double>& dforce,
     std::vector<double>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nghost);
@@ -154,7 +154,7 @@ template void DipoleChargeModifierTF::run_model<float, double>(
 template void DipoleChargeModifierTF::run_model<double, float>(
     std::vector<float>& dforce,
     std::vector<float>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nghost);
@@ -162,7 +162,7 @@ template void DipoleChargeModifierTF::run_model<double, float>(
 template void DipoleChargeModifierTF::run_model<float, float>(
     std::vector<float>& dforce,
     std::vector<float>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nghost);
@@ -280,10 +280,10 @@ void DipoleChargeModifierTF::compute(
   // run model
   std::vector<VALUETYPE> dfcorr, dvcorr;
   if (dtype == tensorflow::DT_DOUBLE) {
-    run_model<double>(dfcorr, dvcorr, session, input_tensors, atommap,
+    run_model<double>(dfcorr, dvcorr, callables, input_tensors, atommap,
                       nghost_real);
   } else {
-    run_model<float>(dfcorr, dvcorr, session, input_tensors, atommap,
+    run_model<float>(dfcorr, dvcorr, callables, input_tensors, atommap,
                      nghost_real);
   }
   assert(dfcorr.size() == nall_real * 3);
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 #include "DeepPot.h"
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 
@@ -26,16 +27,18 @@ DeepPot::DeepPot() { inited = false; }
 
 DeepPot::DeepPot(const std::string& model,
                  const int& gpu_rank,
-                 const std::string& file_content) {
+                 const std::string& file_content,
+                 const int& nthreads) {
   inited = false;
-  init(model, gpu_rank, file_content);
+  init(model, gpu_rank, file_content, nthreads);
 }
 
 DeepPot::~DeepPot() {}
 
 void DeepPot::init(const std::string& model,
                    const int& gpu_rank,
-                   const std::string& file_content) {
+                   const std::string& file_content,
+                   const int& nthreads) {
   if (inited) {
     std::cerr << "WARNING: deepmd-kit should not be initialized twice, do "
                  "nothing at the second call of initializer"
@@ -43,6 +46,8 @@ void DeepPot::init(const std::string& model,
     return;
   }
   const DPBackend backend = get_backend(model);
+  // the backends read the thread budget when they are constructed
+  ScopedThreadBudget thread_budget(nthreads);
   if (deepmd::DPBackend::TensorFlow == backend) {
 #ifdef BUILD_TENSORFLOW
     dp = std::make_shared<deepmd::DeepPotTF>(model, gpu_rank, file_content);
@@ -394,6 +399,124 @@ template void DeepPot::compute<float>(std::vector<ENERGYTYPE>& dener,
                                       const std::vector<float>& fparam,
                                       const std::vector<float>& aparam_);
 
+template <typename VALUETYPE>
+static void computew_buffer_fallback(DeepPotBackend& backend,
+                                     std::vector<ENERGYTYPE>& dener,
+                                     VALUETYPE* dforce,
+                                     VALUETYPE* dvirial,
+                                     VALUETYPE* datom_energy,
+                                     VALUETYPE* datom_virial,
+                                     const std::vector<VALUETYPE>& dcoord_,
+                                     const std::vector<int>& datype_,
+                                     const std::vector<VALUETYPE>& dbox,
+                                     const int nghost,
+                                     const InputNlist& lmp_list,
+                                     const int& ago,
+                                     const std::vector<VALUETYPE>& fparam_,
+                                     const std::vector<VALUETYPE>& aparam__,
+                                     const bool atomic) {
+  std::vector<VALUETYPE> dforce_, dvirial_, datom_energy_, datom_virial_;
+  backend.computew(dener, dforce_, dvirial_, datom_energy_, datom_virial_,
+                   dcoord_, datype_, dbox, nghost, lmp_list, ago, fparam_,
+                   aparam__, atomic);
+  std::copy(dforce_.begin(), dforce_.end(), dforce);
+  if (dvirial) {
+    std::copy(dvirial_.begin(), dvirial_.end(), dvirial);
+  }
+  if (atomic) {
+    std::copy(datom_energy_.begin(), datom_energy_.end(), datom_energy);
+    std::copy(datom_virial_.begin(), datom_virial_.end(), datom_virial);
+  }
+}
+
+void DeepPotBackend::computew_buffer(std::vector<double>& ener,
+                                     double* force,
+                                     double* virial,
+                                     double* atom_energy,
+                                     double* atom_virial,
+                                     const std::vector<double>& coord,
+                                     const std::vector<int>& atype,
+                                     const std::vector<double>& box,
+                                     const int nghost,
+                                     const InputNlist& inlist,
+                                     const int& ago,
+                                     const std::vector<double>& fparam,
+                                     const std::vector<double>& aparam,
+                                     const bool atomic) {
+  computew_buffer_fallback(*this, ener, force, virial, atom_energy,
+                           atom_virial, coord, atype, box, nghost, inlist, ago,
+                           fparam, aparam, atomic);
+}
+
+void DeepPotBackend::computew_buffer(std::vector<double>& ener,
+                                     float* force,
+                                     float* virial,
+                                     float* atom_energy,
+                                     float* atom_virial,
+                                     const std::vector<float>& coord,
+                                     const std::vector<int>& atype,
+                                     const std::vector<float>& box,
+                                     const int nghost,
+                                     const InputNlist& inlist,
+                                     const int& ago,
+                                     const std::vector<float>& fparam,
+                                     const std::vector<float>& aparam,
+                                     const bool atomic) {
+  computew_buffer_fallback(*this, ener, force, virial, atom_energy,
+                           atom_virial, coord, atype, box, nghost, inlist, ago,
+                           fparam, aparam, atomic);
+}
+
+template <typename VALUETYPE>
+void DeepPot::compute(ENERGYTYPE& dener,
+                      VALUETYPE* dforce,
+                      VALUETYPE* dvirial,
+                      VALUETYPE* datom_energy,
+                      VALUETYPE* datom_virial,
+                      const std::vector<VALUETYPE>& dcoord_,
+                      const std::vector<int>& datype_,
+                      const std::vector<VALUETYPE>& dbox,
+                      const int nghost,
+                      const InputNlist& lmp_list,
+                      const int& ago,
+                      const std::vector<VALUETYPE>& fparam_,
+                      const std::vector<VALUETYPE>& aparam__) {
+  std::vector<ENERGYTYPE> dener_;
+  const bool atomic = datom_energy != nullptr && datom_virial != nullptr;
+  dp->computew_buffer(dener_, dforce, dvirial, datom_energy, datom_virial,
+                      dcoord_, datype_, dbox, nghost, lmp_list, ago, fparam_,
+                      aparam__, atomic);
+  dener = dener_[0];
+}
+
+template void DeepPot::compute<double>(ENERGYTYPE& dener,
+                                       double* dforce,
+                                       double* dvirial,
+                                       double* datom_energy,
+                                       double* datom_virial,
+                                       const std::vector<double>& dcoord_,
+                                       const std::vector<int>& datype_,
+                                       const std::vector<double>& dbox,
+                                       const int nghost,
+                                       const InputNlist& lmp_list,
+                                       const int& ago,
+                                       const std::vector<double>& fparam,
+                                       const std::vector<double>& aparam_);
+
+template void DeepPot::compute<float>(ENERGYTYPE& dener,
+                                      float* dforce,
+                                      float* dvirial,
+                                      float* datom_energy,
+                                      float* datom_virial,
+                                      const std::vector<float>& dcoord_,
+                                      const std::vector<int>& datype_,
+                                      const std::vector<float>& dbox,
+                                      const int nghost,
+                                      const InputNlist& lmp_list,
+                                      const int& ago,
+                                      const std::vector<float>& fparam,
+                                      const std::vector<float>& aparam_);
+
 // mixed type
 template <typename VALUETYPE>
 void DeepPot::compute_mixed_type(ENERGYTYPE& dener,
@@ -567,17 +690,19 @@ DeepPotModelDevi::DeepPotModelDevi() {
 DeepPotModelDevi::DeepPotModelDevi(
     const std::vector<std::string>& models,
     const int& gpu_rank,
-    const std::vector<std::string>& file_contents) {
+    const std::vector<std::string>& file_contents,
+    const int& nthreads) {
   inited = false;
   numb_models = 0;
-  init(models, gpu_rank, file_contents);
+  init(models, gpu_rank, file_contents, nthreads);
 }
 
 DeepPotModelDevi::~DeepPotModelDevi() {}
 
 void DeepPotModelDevi::init(const std::vector<std::string>& models,
                             const int& gpu_rank,
-                            const std::vector<std::string>& file_contents) {
+                            const std::vector<std::string>& file_contents,
+                            const int& nthreads) {
   if (inited) {
     std::cerr << "WARNING: deepmd-kit should not be initialized twice, do "
                  "nothing at the second call of initializer"
@@ -593,7 +718,8 @@ void DeepPotModelDevi::init(const std::vector<std::string>& models,
   for (unsigned int ii = 0; ii < numb_models; ++ii) {
     dps[ii] = std::make_shared<deepmd::DeepPot>();
     dps[ii]->init(models[ii], gpu_rank,
-                  file_contents.size() > ii ? file_contents[ii] : "");
+                  file_contents.size() > ii ? file_contents[ii] : "",
+                  nthreads);
     dpbases[ii] = dps[ii];
   }
   inited = true;
@@ -5,7 +5,9 @@
 
 #include <tensorflow/c/c_api.h>
 #include <tensorflow/c/eager/c_api.h>
+#include <tensorflow/c/eager/c_api_experimental.h>
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <cstdio>
@@ -198,6 +200,62 @@ inline TFE_TensorHandle* add_input(TFE_Op* op,
   return handle;
 }
 
+inline TFE_Op* get_cached_func_op(std::map<std::string, TFE_Op*>& ops,
+                                  TFE_Context* ctx,
+                                  const std::string func_name,
+                                  const std::vector<TF_Function*>& funcs,
+                                  const std::string device,
+                                  TF_Status* status) {
+  auto it = ops.find(func_name);
+  if (it == ops.end()) {
+    TFE_Op* op = get_func_op(ctx, func_name, funcs, device, status);
+    ops[func_name] = op;
+    return op;
+  }
+  // release the inputs of the last execution
+  TFE_Op* op = it->second;
+  const std::string real_func_name(TFE_OpGetName(op, status));
+  check_status(status);
+  TFE_OpReset(op, real_func_name.c_str(), device.c_str(), status);
+  check_status(status);
+  return op;
+}
+
+template <typename T>
+inline T* reuse_tensor(TF_Tensor*& tensor,
+                       const std::vector<int64_t>& shape,
+                       bool& reallocated) {
+  const TF_DataType dtype = get_data_tensor_type(std::vector<T>());
+  reallocated = tensor == NULL || TF_TensorType(tensor) != dtype ||
+                TF_NumDims(tensor) != static_cast<int>(shape.size());
+  for (size_t ii = 0; !reallocated && ii < shape.size(); ++ii) {
+    reallocated = TF_Dim(tensor, ii) != shape[ii];
+  }
+  if (reallocated) {
+    if (tensor != NULL) {
+      TF_DeleteTensor(tensor);
+    }
+    size_t len = sizeof(T);
+    for (const int64_t dim : shape) {
+      len *= dim;
+    }
+    tensor = TF_AllocateTensor(dtype, shape.data(), shape.size(), len);
+  }
+  return static_cast<T*>(TF_TensorData(tensor));
+}
+
+inline TFE_TensorHandle* add_input(TFE_Op* op,
+                                   TF_Tensor* data_tensor,
+                                   TF_Status* status) {
+  // a handle may keep a mirror of the tensor on the device, so it is not
+  // reused when the tensor is written in place
+  TFE_TensorHandle* handle = TFE_NewTensorHandle(data_tensor, status);
+  check_status(status);
+  TFE_OpAddInput(op, handle, status);
+  check_status(status);
+  return handle;
+}
+
 template <typename T>
 inline void tensor_to_vector(std::vector<T>& result,
                              TFE_TensorHandle* retval,
@@ -214,11 +272,12 @@ inline void tensor_to_vector(std::vector<T>& result,
   TF_DeleteTensor(tensor);
 }
 
-deepmd::DeepPotJAX::DeepPotJAX() : inited(false) {}
+deepmd::DeepPotJAX::DeepPotJAX()
+    : inited(false), shape_bucketing(PADDING_FACTOR) {}
 deepmd::DeepPotJAX::DeepPotJAX(const std::string& model,
                                const int& gpu_rank,
                                const std::string& file_content)
-    : inited(false) {
+    : inited(false), shape_bucketing(PADDING_FACTOR) {
   init(model, gpu_rank, file_content);
 }
 void deepmd::DeepPotJAX::init(const std::string& model,
@@ -230,6 +289,7 @@ void deepmd::DeepPotJAX::init(const std::string& model,
               << std::endl;
     return;
   }
+  InitTimer timer;
 
   const char* saved_model_dir = model.c_str();
   graph = TF_NewGraph();
@@ -271,6 +331,7 @@ void deepmd::DeepPotJAX::init(const std::string& model,
   session = TF_LoadSessionFromSavedModel(sessionopts, runopts, saved_model_dir,
                                          &tags, ntags, graph, NULL, status);
   check_status(status);
+  timer.record("load saved model");
 
   int nfuncs = TF_GraphNumFunctions(graph);
   // allocate memory for the TF_Function* array
@@ -304,6 +365,7 @@ void deepmd::DeepPotJAX::init(const std::string& model,
     TFE_ContextAddFunction(ctx, func, status);
     check_status(status);
   }
+  timer.record("import functions");
 
   rcut = get_scalar<double>(ctx, "get_rcut", func_vector, device, status);
   dfparam =
@@ -328,13 +390,29 @@ void deepmd::DeepPotJAX::init(const std::string& model,
     do_message_passing = false;
   }
   inited = true;
+  timer.report(model);
 }
 
 deepmd::DeepPotJAX::~DeepPotJAX() {
+  if (shape_bucketing.num_shape_changes() > 0) {
+    std::cout << "DeePMD-kit: JAX model shape changed "
+              << shape_bucketing.num_shape_changes()
+              << " times, recompiled " << shape_bucketing.num_bucket_changes()
+              << " times, avoided " << shape_bucketing.num_avoided()
+              << " recompilations by padding" << std::endl;
+  }
   if (inited) {
     TF_DeleteSession(session, status);
     TF_DeleteGraph(graph);
     TF_DeleteSessionOptions(sessionopts);
+    for (auto& it : func_ops) {
+      TFE_DeleteOp(it.second);
+    }
+    for (TF_Tensor* tensor : lower_inputs) {
+      if (tensor != NULL) {
+        TF_DeleteTensor(tensor);
+      }
+    }
     TF_DeleteStatus(status);
     TFE_DeleteContext(ctx);
     TFE_DeleteContextOptions(ctx_opts);
@@ -390,11 +468,11 @@ void deepmd::DeepPotJAX::compute(std::vector<ENERGYTYPE>& ener,
 
   TFE_Op* op;
   if (atomic) {
-    op = get_func_op(ctx, "call_with_atomic_virial", func_vector, device,
-                     status);
+    op = get_cached_func_op(func_ops, ctx, "call_with_atomic_virial",
+                            func_vector, device, status);
   } else {
-    op = get_func_op(ctx, "call_without_atomic_virial", func_vector, device,
-                     status);
+    op = get_cached_func_op(func_ops, ctx, "call_without_atomic_virial",
+                            func_vector, device, status);
   }
   std::vector<TFE_TensorHandle*> input_list(5);
   std::vector<TF_Tensor*> data_tensor(5);
@@ -488,7 +566,6 @@ void deepmd::DeepPotJAX::compute(std::vector<ENERGYTYPE>& ener,
   for (size_t i = 0; i < nretvals; i++) {
     TFE_DeleteTensorHandle(retvals[i]);
   }
-  TFE_DeleteOp(op);
 }
 
 template <typename VALUETYPE>
@@ -530,92 +607,117 @@ void deepmd::DeepPotJAX::compute(std::vector<ENERGYTYPE>& ener,
     return;
   }
 
-  // cast coord, fparam, and aparam to double - I think it's useless to have a
-  // float model interface
-  std::vector<double> coord_double(coord.begin(), coord.end());
-  std::vector<double> fparam_double(fparam.begin(), fparam.end());
-  std::vector<double> aparam_double(aparam.begin(), aparam.end());
-
-  if (padding_for_nloc != nloc_real) {
-    padding_to_nall = nall_real * PADDING_FACTOR;
-    padding_for_nloc = nloc_real;
+  // nlist
+  if (ago == 0) {
+    nlist_data.copy_from_nlist(lmp_list, nall - nghost);
+    nlist_data.shuffle_exclude_empty(fwd_map);
   }
-  while (padding_to_nall < nall_real) {
-    padding_to_nall *= PADDING_FACTOR;
+  size_t max_size = 0;
+  for (const auto& row : nlist_data.jlist) {
+    max_size = std::max(max_size, row.size());
   }
-  // do padding
-  coord_double.resize(nframes * padding_to_nall * 3, 0.0);
-  atype.resize(nframes * padding_to_nall, -1);
+  shape_bucketing.update(nloc_real, nall_real, max_size);
+  const int nloc_padded = shape_bucketing.nloc_padded;
+  const int nall_padded = shape_bucketing.nall_padded;
+  const int nnei_padded = shape_bucketing.nnei_padded;
 
   TFE_Op* op;
   if (atomic) {
-    op = get_func_op(ctx, "call_lower_with_atomic_virial", func_vector, device,
-                     status);
+    op = get_cached_func_op(func_ops, ctx, "call_lower_with_atomic_virial",
+                            func_vector, device, status);
   } else {
-    op = get_func_op(ctx, "call_lower_without_atomic_virial", func_vector,
-                     device, status);
+    op = get_cached_func_op(func_ops, ctx, "call_lower_without_atomic_virial",
+                            func_vector, device, status);
   }
+  // the input tensors are kept between calls and written in place; the
+  // atom types, the neighbor list, and the mapping are only written when the
+  // neighbor list is rebuilt or the padded shapes change
+  lower_inputs.resize(6, NULL);
   std::vector<TFE_TensorHandle*> input_list(6);
-  std::vector<TF_Tensor*> data_tensor(6);
-  // coord
-  std::vector<int64_t> coord_shape = {nframes, padding_to_nall, 3};
-  input_list[0] =
-      add_input(op, coord_double, coord_shape, data_tensor[0], status);
-  // atype
-  std::vector<int64_t> atype_shape = {nframes, padding_to_nall};
-  input_list[1] = add_input(op, atype, atype_shape, data_tensor[1], status);
-  // nlist
-  if (ago == 0) {
-    nlist_data.copy_from_nlist(lmp_list, nall - nghost);
-    nlist_data.shuffle_exclude_empty(fwd_map);
+  bool reallocated;
+  // coord, cast to double - I think it's useless to have a float model
+  // interface; padding atoms are placed at the origin
+  std::vector<int64_t> coord_shape = {nframes, nall_padded, 3};
+  double* coord_double =
+      reuse_tensor<double>(lower_inputs[0], coord_shape, reallocated);
+  std::fill(coord_double, coord_double + nframes * nall_padded * 3, 0.0);
+  for (int ii = 0; ii < nall_real; ii++) {
+    const int jj = shape_bucketing.padded_index(ii);
+    for (int dd = 0; dd < 3; dd++) {
+      coord_double[jj * 3 + dd] = coord[ii * 3 + dd];
+    }
   }
-  size_t max_size = 0;
-  for (const auto& row : nlist_data.jlist) {
-    max_size = std::max(max_size, row.size());
+  input_list[0] = add_input(op, lower_inputs[0], status);
+  // atype; padding atoms have the type -1
+  std::vector<int64_t> atype_shape = {nframes, nall_padded};
+  int32_t* atype_padded =
+      reuse_tensor<int32_t>(lower_inputs[1], atype_shape, reallocated);
+  if (ago == 0 || reallocated) {
+    std::fill(atype_padded, atype_padded + nframes * nall_padded, -1);
+    for (int ii = 0; ii < nall_real; ii++) {
+      atype_padded[shape_bucketing.padded_index(ii)] = atype[ii];
+    }
   }
-  std::vector<int64_t> nlist_shape = {nframes, nloc_real,
-                                      static_cast<int64_t>(max_size)};
-  std::vector<int64_t> nlist(static_cast<size_t>(nframes) * nloc_real *
-                             max_size);
-  // pass nlist_data.jlist to nlist
-  for (int ii = 0; ii < nloc_real; ii++) {
-    for (int jj = 0; jj < max_size; jj++) {
-      if (jj < nlist_data.jlist[ii].size()) {
-        nlist[ii * max_size + jj] = nlist_data.jlist[ii][jj];
-      } else {
-        nlist[ii * max_size + jj] = -1;
+  input_list[1] = add_input(op, lower_inputs[1], status);
+  // nlist
+  std::vector<int64_t> nlist_shape = {nframes, nloc_padded, nnei_padded};
+  int64_t* nlist =
+      reuse_tensor<int64_t>(lower_inputs[2], nlist_shape, reallocated);
+  if (ago == 0 || reallocated) {
+    std::fill(nlist, nlist + nframes * nloc_padded * nnei_padded, -1);
+    // pass nlist_data.jlist to nlist
+    for (int ii = 0; ii < nloc_real; ii++) {
+      for (int jj = 0; jj < nlist_data.jlist[ii].size(); jj++) {
+        nlist[ii * nnei_padded + jj] =
+            shape_bucketing.padded_index(nlist_data.jlist[ii][jj]);
       }
     }
   }
-  input_list[2] = add_input(op, nlist, nlist_shape, data_tensor[2], status);
+  input_list[2] = add_input(op, lower_inputs[2], status);
   // mapping; for now, set it to -1, assume it is not used
-  std::vector<int64_t> mapping_shape = {nframes, padding_to_nall};
-  std::vector<int64_t> mapping(nframes * padding_to_nall, -1);
-  // pass mapping if it is given in the neighbor list
-  if (lmp_list.mapping) {
-    // assume nframes is 1
-    for (size_t ii = 0; ii < nall_real; ii++) {
-      mapping[ii] = lmp_list.mapping[fwd_map[ii]];
+  std::vector<int64_t> mapping_shape = {nframes, nall_padded};
+  int64_t* mapping =
+      reuse_tensor<int64_t>(lower_inputs[3], mapping_shape, reallocated);
+  if (ago == 0 || reallocated) {
+    std::fill(mapping, mapping + nframes * nall_padded, -1);
+    // pass mapping if it is given in the neighbor list
+    // mapped indexes are local atoms, which are not moved by the padding
+    if (lmp_list.mapping) {
+      // assume nframes is 1
+      for (size_t ii = 0; ii < nall_real; ii++) {
+        mapping[shape_bucketing.padded_index(ii)] =
+            lmp_list.mapping[fwd_map[ii]];
+      }
+    } else if (nloc_real == nall_real) {
+      // no ghost atoms
+      for (size_t ii = 0; ii < nall_real; ii++) {
+        mapping[ii] = ii;
+      }
+    } else if (do_message_passing) {
+      throw deepmd::deepmd_exception(
+          "Mapping is required for a message passing model. If you are using "
+          "LAMMPS, set `atom_modify map yes`");
     }
-  } else if (nloc_real == nall_real) {
-    // no ghost atoms
-    for (size_t ii = 0; ii < nall_real; ii++) {
+    // padding local atoms are mapped to themselves
+    for (int ii = nloc_real; ii < nloc_padded; ii++) {
       mapping[ii] = ii;
     }
-  } else if (do_message_passing) {
-    throw deepmd::deepmd_exception(
-        "Mapping is required for a message passing model. If you are using "
-        "LAMMPS, set `atom_modify map yes`");
   }
-  input_list[3] = add_input(op, mapping, mapping_shape, data_tensor[3], status);
+  input_list[3] = add_input(op, lower_inputs[3], status);
   // fparam
   std::vector<int64_t> fparam_shape = {nframes, dfparam};
-  input_list[4] =
-      add_input(op, fparam_double, fparam_shape, data_tensor[4], status);
-  // aparam
-  std::vector<int64_t> aparam_shape = {nframes, nloc_real, daparam};
-  input_list[5] =
-      add_input(op, aparam_double, aparam_shape, data_tensor[5], status);
+  double* fparam_double =
+      reuse_tensor<double>(lower_inputs[4], fparam_shape, reallocated);
+  std::copy(fparam.begin(), fparam.end(), fparam_double);
+  input_list[4] = add_input(op, lower_inputs[4], status);
+  // aparam; padding atoms have zero aparam
+  std::vector<int64_t> aparam_shape = {nframes, nloc_padded, daparam};
+  double* aparam_double =
+      reuse_tensor<double>(lower_inputs[5], aparam_shape, reallocated);
+  std::fill(aparam_double + aparam.size(),
+            aparam_double + nframes * nloc_padded * daparam, 0.0);
+  std::copy(aparam.begin(), aparam.end(), aparam_double);
+  input_list[5] = add_input(op, lower_inputs[5], status);
   // execute the function
   int nretvals = 6;
   TFE_TensorHandle* retvals[nretvals];
@@ -639,20 +741,25 @@ void deepmd::DeepPotJAX::compute(std::vector<ENERGYTYPE>& ener,
   tensor_to_vector(atom_energy_double, retvals[0], status);
   tensor_to_vector(atom_virial_double, retvals[1], status);
 
-  // cast back to VALUETYPE
+  // cast back to VALUETYPE and remove padding atoms
   ener = std::vector<ENERGYTYPE>(ener_double.begin(), ener_double.end());
-  force = std::vector<VALUETYPE>(force_double.begin(), force_double.end());
   virial = std::vector<VALUETYPE>(virial_double.begin(), virial_double.end());
-  atom_energy = std::vector<VALUETYPE>(atom_energy_double.begin(),
-                                       atom_energy_double.end());
-  atom_virial = std::vector<VALUETYPE>(atom_virial_double.begin(),
-                                       atom_virial_double.end());
   force.resize(static_cast<size_t>(nframes) * nall_real * 3);
   atom_virial.resize(static_cast<size_t>(nframes) * nall_real * 9);
-
   // nall atom_energy is required in the C++ API;
   // we always forget it!
-  atom_energy.resize(static_cast<size_t>(nframes) * nall_real, 0.0);
+  atom_energy.assign(static_cast<size_t>(nframes) * nall_real, 0.0);
+  for (int ii = 0; ii < nall_real; ii++) {
+    const int jj = shape_bucketing.padded_index(ii);
+    for (int dd = 0; dd < 3; dd++) {
+      force[ii * 3 + dd] = force_double[jj * 3 + dd];
+    }
+    for (int dd = 0; dd < 9; dd++) {
+      atom_virial[ii * 9 + dd] = atom_virial_double[jj * 9 + dd];
+    }
+  }
+  std::copy(atom_energy_double.begin(),
+            atom_energy_double.begin() + nloc_real, atom_energy.begin());
 
   force_.resize(static_cast<size_t>(nframes) * fwd_map.size() * 3);
   atom_energy_.resize(static_cast<size_t>(nframes) * fwd_map.size());
@@ -667,12 +774,10 @@ void deepmd::DeepPotJAX::compute(std::vector<ENERGYTYPE>& ener,
   // cleanup input_list, etc
   for (size_t i = 0; i < 6; i++) {
     TFE_DeleteTensorHandle(input_list[i]);
-    TF_DeleteTensor(data_tensor[i]);
   }
   for (size_t i = 0; i < nretvals; i++) {
     TFE_DeleteTensorHandle(retvals[i]);
   }
-  TFE_DeleteOp(op);
 }
 
 template void deepmd::DeepPotJAX::compute<double>(
@@ -20,6 +20,24 @@ std::vector<int> createNlistTensorPD(
   return ret;
 }
 
+/**
+ * @brief Set the data of an input tensor.
+ * @details On CPUs, the tensor shares the memory of the data, which should
+ * be alive until the predictor runs. On GPUs, the data is copied.
+ **/
+template <typename T>
+static void set_input_tensor(paddle_infer::Tensor& tensor,
+                             const T* data,
+                             const std::vector<int>& shape,
+                             const bool gpu_enabled) {
+  if (gpu_enabled) {
+    tensor.Reshape(shape);
+    tensor.CopyFromCpu(data);
+  } else {
+    tensor.ShareExternalData(data, shape, paddle_infer::PlaceType::kCPU);
+  }
+}
+
 DeepPotPD::DeepPotPD() : inited(false) {}
 DeepPotPD::DeepPotPD(const std::string& model,
                      const int& gpu_rank,
@@ -42,7 +60,8 @@ void DeepPotPD::init(const std::string& model,
     return;
   }
   // NOTE: There is no custom operators need to be loaded now.
-  // deepmd::load_op_library();
+  // deepmd::load_op_library(DPBackend::Paddle);
+  InitTimer timer;
 
   // NOTE: Only support 1 GPU now.
   int gpu_num = 1;
@@ -121,19 +140,18 @@ void DeepPotPD::init(const std::string& model,
               << std::endl;
   }
 
-  // NOTE: Both set to 1 now.
-  // get_env_nthreads(num_intra_nthreads,
-  //                  num_inter_nthreads);  // need to be fixed as
-  //                                        // DP_INTRA_OP_PARALLELISM_THREADS
-  // num_intra_nthreads = 1;
-  num_inter_nthreads = 1;
-  if (num_inter_nthreads) {
-    config->SetCpuMathLibraryNumThreads(num_inter_nthreads);
-    config_fl->SetCpuMathLibraryNumThreads(num_inter_nthreads);
+  // Paddle runs the operators one by one, so only the intra-op threads,
+  // which are the threads of the math library, are used
+  get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
+  if (num_intra_nthreads > 0) {
+    config->SetCpuMathLibraryNumThreads(num_intra_nthreads);
+    config_fl->SetCpuMathLibraryNumThreads(num_intra_nthreads);
   }
 
   predictor = paddle_infer::CreatePredictor(*config);
   predictor_fl = paddle_infer::CreatePredictor(*config_fl);
+  predictor_pool.push_back(predictor);
+  timer.record("create predictors");
 
   // initialize hyper params from model buffers
   ntypes_spin = 0;
@@ -144,9 +162,26 @@ void DeepPotPD::init(const std::string& model,
   DeepPotPD::get_buffer<int>("buffer_daparam", daparam);
   DeepPotPD::get_buffer<int>("buffer_aparam_nall", aparam_nall);
   inited = true;
+  timer.report(model);
 }
 DeepPotPD::~DeepPotPD() {}
 
+std::shared_ptr<paddle_infer::Predictor> DeepPotPD::acquire_predictor() {
+  std::lock_guard<std::mutex> lock(predictor_pool_mutex);
+  if (predictor_pool.empty()) {
+    return predictor->Clone();
+  }
+  std::shared_ptr<paddle_infer::Predictor> pred = predictor_pool.back();
+  predictor_pool.pop_back();
+  return pred;
+}
+
+void DeepPotPD::release_predictor(
+    std::shared_ptr<paddle_infer::Predictor> pred) {
+  std::lock_guard<std::mutex> lock(predictor_pool_mutex);
+  predictor_pool.push_back(pred);
+}
+
 template <typename VALUETYPE, typename ENERGYVTYPE>
 void DeepPotPD::compute(ENERGYVTYPE& ener,
                         std::vector<VALUETYPE>& force,
@@ -173,14 +208,12 @@ void DeepPotPD::compute(ENERGYVTYPE& ener,
                           nghost, ntypes, 1, daparam, nall, aparam_nall);
   int nloc = nall_real - nghost_real;
   int nframes = 1;
-  std::vector<VALUETYPE> coord_wrapped = dcoord;
   auto coord_wrapped_Tensor = predictor_fl->GetInputHandle("coord");
-  coord_wrapped_Tensor->Reshape({1, nall_real, 3});
-  coord_wrapped_Tensor->CopyFromCpu(coord_wrapped.data());
+  set_input_tensor(*coord_wrapped_Tensor, dcoord.data(), {1, nall_real, 3},
+                   gpu_enabled);
 
   auto atype_Tensor = predictor_fl->GetInputHandle("atype");
-  atype_Tensor->Reshape({1, nall_real});
-  atype_Tensor->CopyFromCpu(datype.data());
+  set_input_tensor(*atype_Tensor, datype.data(), {1, nall_real}, gpu_enabled);
 
   if (ago == 0) {
     nlist_data.copy_from_nlist(lmp_list);
@@ -218,24 +251,25 @@ void DeepPotPD::compute(ENERGYVTYPE& ener,
       throw deepmd::deepmd_exception(
           "(do_message_passing == 1 && nghost == 0) is not supported yet.");
     }
+    firstneigh = createNlistTensorPD(nlist_data.jlist);
   }
-  std::vector<int> firstneigh = createNlistTensorPD(nlist_data.jlist);
   firstneigh_tensor = predictor_fl->GetInputHandle("nlist");
-  firstneigh_tensor->Reshape({1, nloc, (int)firstneigh.size() / (int)nloc});
-  firstneigh_tensor->CopyFromCpu(firstneigh.data());
+  set_input_tensor(*firstneigh_tensor, firstneigh.data(),
+                   {1, nloc, (int)firstneigh.size() / (int)nloc}, gpu_enabled);
   bool do_atom_virial_tensor = atomic;
   std::unique_ptr<paddle_infer::Tensor> fparam_tensor;
   if (!fparam.empty()) {
     fparam_tensor = predictor_fl->GetInputHandle("fparam");
-    fparam_tensor->Reshape({1, static_cast<int>(fparam.size())});
-    fparam_tensor->CopyFromCpu((fparam.data()));
+    set_input_tensor(*fparam_tensor, fparam.data(),
+                     {1, static_cast<int>(fparam.size())}, gpu_enabled);
   }
   std::unique_ptr<paddle_infer::Tensor> aparam_tensor;
   if (!aparam_.empty()) {
     aparam_tensor = predictor_fl->GetInputHandle("aparam");
-    aparam_tensor->Reshape(
-        {1, lmp_list.inum, static_cast<int>(aparam_.size()) / lmp_list.inum});
-    aparam_tensor->CopyFromCpu((aparam_.data()));
+    set_input_tensor(
+        *aparam_tensor, aparam_.data(),
+        {1, lmp_list.inum, static_cast<int>(aparam_.size()) / lmp_list.inum},
+        gpu_enabled);
   }
 
   if (!predictor_fl->Run()) {
@@ -326,48 +360,46 @@ void DeepPotPD::compute(ENERGYVTYPE& ener,
                         const std::vector<VALUETYPE>& fparam,
                         const std::vector<VALUETYPE>& aparam,
                         const bool atomic) {
-  // select real atoms
-  std::vector<VALUETYPE> coord_wrapped = coord;
   int natoms = atype.size();
   int nframes = 1;
-  auto coord_wrapped_Tensor = predictor->GetInputHandle("coord");
-  coord_wrapped_Tensor->Reshape({1, natoms, 3});
-  coord_wrapped_Tensor->CopyFromCpu(coord_wrapped.data());
+  // concurrent callers run on different predictors
+  PredictorGuard pred(*this);
+  auto coord_wrapped_Tensor = pred->GetInputHandle("coord");
+  set_input_tensor(*coord_wrapped_Tensor, coord.data(), {1, natoms, 3},
+                   gpu_enabled);
 
   std::vector<std::int64_t> atype_64(atype.begin(), atype.end());
-  auto atype_Tensor = predictor->GetInputHandle("atype");
-  atype_Tensor->Reshape({1, natoms});
-  atype_Tensor->CopyFromCpu(atype_64.data());
+  auto atype_Tensor = pred->GetInputHandle("atype");
+  set_input_tensor(*atype_Tensor, atype_64.data(), {1, natoms}, gpu_enabled);
 
   std::unique_ptr<paddle_infer::Tensor> box_Tensor;
   if (!box.empty()) {
-    box_Tensor = predictor->GetInputHandle("box");
-    box_Tensor->Reshape({1, 9});
-    box_Tensor->CopyFromCpu((box.data()));
+    box_Tensor = pred->GetInputHandle("box");
+    set_input_tensor(*box_Tensor, box.data(), {1, 9}, gpu_enabled);
   }
   std::unique_ptr<paddle_infer::Tensor> fparam_tensor;
   if (!fparam.empty()) {
-    fparam_tensor = predictor->GetInputHandle("box");
-    fparam_tensor->Reshape({1, static_cast<int>(fparam.size())});
-    fparam_tensor->CopyFromCpu((fparam.data()));
+    fparam_tensor = pred->GetInputHandle("fparam");
+    set_input_tensor(*fparam_tensor, fparam.data(),
+                     {1, static_cast<int>(fparam.size())}, gpu_enabled);
   }
   std::unique_ptr<paddle_infer::Tensor> aparam_tensor;
   if (!aparam.empty()) {
-    aparam_tensor = predictor->GetInputHandle("box");
-    aparam_tensor->Reshape(
-        {1, natoms, static_cast<int>(aparam.size()) / natoms});
-    aparam_tensor->CopyFromCpu((aparam.data()));
+    aparam_tensor = pred->GetInputHandle("aparam");
+    set_input_tensor(*aparam_tensor, aparam.data(),
+                     {1, natoms, static_cast<int>(aparam.size()) / natoms},
+                     gpu_enabled);
   }
 
   bool do_atom_virial_tensor = atomic;
-  if (!predictor->Run()) {
+  if (!pred->Run()) {
     throw deepmd::deepmd_exception("Paddle inference run failed");
   }
 
-  auto output_names = predictor->GetOutputNames();
-  auto energy_ = predictor->GetOutputHandle(output_names.at(2));
-  auto force_ = predictor->GetOutputHandle(output_names.at(3));
-  auto virial_ = predictor->GetOutputHandle(output_names.at(5));
+  auto output_names = pred->GetOutputNames();
+  auto energy_ = pred->GetOutputHandle(output_names.at(2));
+  auto force_ = pred->GetOutputHandle(output_names.at(3));
+  auto virial_ = pred->GetOutputHandle(output_names.at(5));
 
   int enery_numel = numel(*energy_);
   assert(enery_numel > 0);
@@ -385,8 +417,8 @@ void DeepPotPD::compute(ENERGYVTYPE& ener,
   virial_->CopyToCpu(virial.data());
 
   if (atomic) {
-    auto atom_energy_ = predictor->GetOutputHandle(output_names.at(0));
-    auto atom_virial_ = predictor->GetOutputHandle(output_names.at(1));
+    auto atom_energy_ = pred->GetOutputHandle(output_names.at(0));
+    auto atom_virial_ = pred->GetOutputHandle(output_names.at(1));
     int atom_energy_numel = numel(*atom_energy_);
     int atom_virial_numel = numel(*atom_virial_);
     assert(atom_energy_numel > 0);
@@ -4,9 +4,17 @@
 
 #include <torch/csrc/jit/runtime/jit_exception.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
 
 #include "common.h"
+#include "commonPT.h"
 #include "device.h"
 #include "errors.h"
 
@@ -30,27 +38,53 @@ void DeepPotPT::translate_error(std::function<void()> f) {
   }
 }
 
-torch::Tensor createNlistTensor(const std::vector<std::vector<int>>& data) {
-  size_t total_size = 0;
-  for (const auto& row : data) {
-    total_size += row.size();
+namespace deepmd {
+template <>
+TorchInputWorkspace<double>& DeepPotPT::workspace<double>() {
+  return workspace_double;
+}
+template <>
+TorchInputWorkspace<float>& DeepPotPT::workspace<float>() {
+  return workspace_float;
+}
+}  // namespace deepmd
+/**
+ * @brief Read the warm-up shapes from DP_PT_WARMUP_SHAPES.
+ * @details The shapes are given as nloc:nall:nnei and split by commas, e.g.
+ * 192:1024:120,384:2048:120.
+ * @param[out] shapes The list of (nloc, nall, nnei).
+ */
+static void get_env_warmup_shapes(std::vector<std::array<int, 3>>& shapes) {
+  shapes.clear();
+  const char* env_shapes = std::getenv("DP_PT_WARMUP_SHAPES");
+  if (!env_shapes) {
+    return;
   }
-  std::vector<int> flat_data;
-  flat_data.reserve(total_size);
-  for (const auto& row : data) {
-    flat_data.insert(flat_data.end(), row.begin(), row.end());
+  std::stringstream ss(env_shapes);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (item.empty()) {
+      continue;
+    }
+    std::array<int, 3> shape;
+    char sep1, sep2;
+    std::stringstream ss_item(item);
+    if (!(ss_item >> shape[0] >> sep1 >> shape[1] >> sep2 >> shape[2]) ||
+        sep1 != ':' || sep2 != ':' || shape[0] <= 0 || shape[1] < shape[0] ||
+        shape[2] <= 0) {
+      throw deepmd::deepmd_exception(
+          "Invalid shape in DP_PT_WARMUP_SHAPES: " + item +
+          ", which should be nloc:nall:nnei with 0 < nloc <= nall");
+    }
+    shapes.push_back(shape);
   }
-
-  torch::Tensor flat_tensor = torch::tensor(flat_data, torch::kInt32);
-  int nloc = data.size();
-  int nnei = nloc > 0 ? total_size / nloc : 0;
-  return flat_tensor.view({1, nloc, nnei});
 }
-DeepPotPT::DeepPotPT() : inited(false) {}
+
+DeepPotPT::DeepPotPT() : inited(false), shape_bucketing_enabled(false) {}
 DeepPotPT::DeepPotPT(const std::string& model,
                      const int& gpu_rank,
                      const std::string& file_content)
-    : inited(false) {
+    : inited(false), shape_bucketing_enabled(false) {
   try {
     translate_error([&] { init(model, gpu_rank, file_content); });
   } catch (...) {
@@ -67,7 +101,9 @@ void DeepPotPT::init(const std::string& model,
               << std::endl;
     return;
   }
-  deepmd::load_op_library();
+  InitTimer timer;
+  deepmd::load_op_library(DPBackend::PyTorch);
+  timer.record("load OP library");
   int gpu_num = torch::cuda::device_count();
   if (gpu_num > 0) {
     gpu_id = gpu_rank % gpu_num;
@@ -89,6 +125,7 @@ void DeepPotPT::init(const std::string& model,
   std::unordered_map<std::string, std::string> metadata = {{"type", ""}};
   module = torch::jit::load(model, device, metadata);
   module.eval();
+  timer.record("load model");
   do_message_passing = module.run_method("has_message_passing").toBool();
   torch::jit::FusionStrategy strategy;
   strategy = {{torch::jit::FusionBehavior::DYNAMIC, 10}};
@@ -103,12 +140,7 @@ void DeepPotPT::init(const std::string& model,
     } catch (...) {
     }
   }
-  if (num_intra_nthreads) {
-    try {
-      at::set_num_threads(num_intra_nthreads);
-    } catch (...) {
-    }
-  }
+  apply_nthreads();
 
   auto rcut_ = module.run_method("get_rcut").toDouble();
   rcut = static_cast<double>(rcut_);
@@ -117,16 +149,118 @@ void DeepPotPT::init(const std::string& model,
   dfparam = module.run_method("get_dim_fparam").toInt();
   daparam = module.run_method("get_dim_aparam").toInt();
   aparam_nall = module.run_method("is_aparam_nall").toBool();
+  const char* env_bucketing = std::getenv("DP_PT_SHAPE_BUCKETING");
+  shape_bucketing_enabled =
+      env_bucketing && std::string(env_bucketing) != "0" && !do_message_passing;
   inited = true;
+
+  std::vector<std::array<int, 3>> shapes;
+  get_env_warmup_shapes(shapes);
+  warmup(shapes);
+  timer.report(model);
+}
+DeepPotPT::~DeepPotPT() {
+  if (shape_bucketing.num_shape_changes() > 0 && is_first_rank()) {
+    std::cout << "DeePMD-kit: PyTorch model shape changed "
+              << shape_bucketing.num_shape_changes()
+              << " times, respecialized "
+              << shape_bucketing.num_bucket_changes()
+              << " times, avoided " << shape_bucketing.num_avoided()
+              << " respecializations by padding" << std::endl;
+  }
+}
+
+void DeepPotPT::apply_nthreads() {
+  // the intra-op pool of PyTorch is shared by the process, so models with
+  // different thread budgets need to set it before each evaluation; models
+  // evaluated in several threads at once, e.g. by the pipelined fix dplr of
+  // LAMMPS, set it one at a time
+  if (num_intra_nthreads == 0) {
+    return;
+  }
+  static std::mutex nthreads_mutex;
+  std::lock_guard<std::mutex> lock(nthreads_mutex);
+  if (at::get_num_threads() != num_intra_nthreads) {
+    try {
+      at::set_num_threads(num_intra_nthreads);
+    } catch (const c10::Error& e) {
+      // the evaluation still works with the current pool, so only warn once
+      static std::once_flag warned;
+      std::call_once(warned, [&e] {
+        std::cerr << "WARNING: failed to set the number of PyTorch intra-op "
+                     "threads: "
+                  << e.what() << std::endl;
+      });
+    }
+  }
+}
+
+void DeepPotPT::warmup(const std::vector<std::array<int, 3>>& shapes) {
+  const int max_specializations = 10;
+  if (warmup_shapes.size() + pending_warmup_shapes.size() + shapes.size() >
+          static_cast<size_t>(max_specializations) &&
+      is_first_rank()) {
+    std::cerr << "WARNING: more warm-up shapes than the fusion depth ("
+              << max_specializations
+              << "); the earliest specializations may be evicted" << std::endl;
+  }
+  pending_warmup_shapes.insert(pending_warmup_shapes.end(), shapes.begin(),
+                               shapes.end());
+}
+
+/**
+ * @brief Copy a per-atom output tensor into a caller-provided buffer.
+ * @details If bkw_map is empty, the tensor is copied into the buffer in a
+ * single pass, which also performs the dtype cast and the device transfer if
+ * needed. Otherwise the rows are scattered back by bkw_map; atoms without a
+ * row in the tensor are set to zero.
+ * @param[out] out The output buffer of size nall x stride.
+ * @param[in] in The output tensor.
+ * @param[in] bkw_map The backward map from the rows of the tensor to all
+ * atoms. Rows mapped to -1 are dropped. An empty map means identity.
+ * @param[in] stride The number of values per atom.
+ * @param[in] nall The number of atoms in the output buffer.
+ */
+template <typename VALUETYPE>
+static void copy_to_buffer(VALUETYPE* out,
+                           const torch::Tensor& in,
+                           const std::vector<int>& bkw_map,
+                           const int stride,
+                           const int nall) {
+  torch::ScalarType floatType = torch::kFloat64;
+  if (std::is_same<VALUETYPE, float>::value) {
+    floatType = torch::kFloat32;
+  }
+  torch::Tensor flat = in.view({-1});
+  const int64_t nin = flat.numel();
+  const size_t nout = static_cast<size_t>(nall) * stride;
+  if (bkw_map.empty()) {
+    torch::from_blob(out, {nin}, torch::TensorOptions().dtype(floatType))
+        .copy_(flat);
+    std::fill(out + nin, out + nout, static_cast<VALUETYPE>(0));
+    return;
+  }
+  // no-op if the dtype and the device already match
+  torch::Tensor cpu_flat = flat.to(torch::kCPU, floatType);
+  const VALUETYPE* in_ptr = cpu_flat.data_ptr<VALUETYPE>();
+  std::fill(out, out + nout, static_cast<VALUETYPE>(0));
+  for (int64_t ii = 0; ii < nin / stride; ++ii) {
+    const int to_ii = bkw_map[ii];
+    if (to_ii < 0) {
+      continue;
+    }
+    for (int dd = 0; dd < stride; ++dd) {
+      out[static_cast<size_t>(to_ii) * stride + dd] = in_ptr[ii * stride + dd];
+    }
+  }
 }
-DeepPotPT::~DeepPotPT() {}
 
 template <typename VALUETYPE, typename ENERGYVTYPE>
 void DeepPotPT::compute(ENERGYVTYPE& ener,
-                        std::vector<VALUETYPE>& force,
-                        std::vector<VALUETYPE>& virial,
-                        std::vector<VALUETYPE>& atom_energy,
-                        std::vector<VALUETYPE>& atom_virial,
+                        VALUETYPE* force,
+                        VALUETYPE* virial,
+                        VALUETYPE* atom_energy,
+                        VALUETYPE* atom_virial,
                         const std::vector<VALUETYPE>& coord,
                         const std::vector<int>& atype,
                         const std::vector<VALUETYPE>& box,
@@ -136,23 +270,25 @@ void DeepPotPT::compute(ENERGYVTYPE& ener,
                         const std::vector<VALUETYPE>& fparam,
                         const std::vector<VALUETYPE>& aparam,
                         const bool atomic) {
+  // the warm-up replaces the neighbor list, the mapping, and the
+  // communication, so it waits for a call that rebuilds them afterwards
+  if (ago == 0 && !pending_warmup_shapes.empty()) {
+    run_warmup<VALUETYPE>(lmp_list);
+  }
+  apply_nthreads();
   torch::Device device(torch::kCUDA, gpu_id);
   if (!gpu_enabled) {
     device = torch::Device(torch::kCPU);
   }
   int natoms = atype.size();
   auto options = torch::TensorOptions().dtype(torch::kFloat64);
-  torch::ScalarType floatType = torch::kFloat64;
   if (std::is_same<VALUETYPE, float>::value) {
     options = torch::TensorOptions().dtype(torch::kFloat32);
-    floatType = torch::kFloat32;
   }
   auto int32_option =
       torch::TensorOptions().device(torch::kCPU).dtype(torch::kInt32);
-  auto int_option =
-      torch::TensorOptions().device(torch::kCPU).dtype(torch::kInt64);
   // select real atoms
-  std::vector<VALUETYPE> dcoord, dforce, aparam_, datom_energy, datom_virial;
+  std::vector<VALUETYPE> dcoord, aparam_;
   std::vector<int> datype, fwd_map, bkw_map;
   int nghost_real, nall_real, nloc_real;
   int nall = natoms;
@@ -160,18 +296,16 @@ void DeepPotPT::compute(ENERGYVTYPE& ener,
                           bkw_map, nall_real, nloc_real, coord, atype, aparam,
                           nghost, ntypes, 1, daparam, nall, aparam_nall);
   int nloc = nall_real - nghost_real;
-  int nframes = 1;
-  std::vector<VALUETYPE> coord_wrapped = dcoord;
-  at::Tensor coord_wrapped_Tensor =
-      torch::from_blob(coord_wrapped.data(), {1, nall_real, 3}, options)
-          .to(device);
-  std::vector<std::int64_t> atype_64(datype.begin(), datype.end());
-  at::Tensor atype_Tensor =
-      torch::from_blob(atype_64.data(), {1, nall_real}, int_option).to(device);
+  // the layout of atoms can not be changed when communicating across ranks
+  const bool bucketing = shape_bucketing_enabled && !do_message_passing;
   if (ago == 0) {
     nlist_data.copy_from_nlist(lmp_list, nall - nghost);
     nlist_data.shuffle_exclude_empty(fwd_map);
-    nlist_data.padding();
+    nlist_data.padding(warmup_nnei);
+    const int nnei = nloc_real > 0 ? nlist_data.jlist[0].size() : 0;
+    if (bucketing) {
+      shape_bucketing.update(nloc_real, nall_real, nnei);
+    }
     if (do_message_passing) {
       int nswap = lmp_list.nswap;
       torch::Tensor sendproc_tensor =
@@ -197,42 +331,109 @@ void DeepPotPT::compute(ENERGYVTYPE& ener,
           std::accumulate(lmp_list.sendnum, lmp_list.sendnum + nswap, 0);
       torch::Tensor sendlist_tensor =
           torch::from_blob(lmp_list.sendlist, {total_send}, int32_option);
-      comm_dict.insert("send_list", sendlist_tensor);
-      comm_dict.insert("send_proc", sendproc_tensor);
-      comm_dict.insert("recv_proc", recvproc_tensor);
-      comm_dict.insert("send_num", sendnum_tensor);
-      comm_dict.insert("recv_num", recvnum_tensor);
-      comm_dict.insert("communicator", communicator_tensor);
+      comm_dict.insert_or_assign("send_list", sendlist_tensor);
+      comm_dict.insert_or_assign("send_proc", sendproc_tensor);
+      comm_dict.insert_or_assign("recv_proc", recvproc_tensor);
+      comm_dict.insert_or_assign("send_num", sendnum_tensor);
+      comm_dict.insert_or_assign("recv_num", recvnum_tensor);
+      comm_dict.insert_or_assign("communicator", communicator_tensor);
+    }
+    if (bucketing) {
+      // padding atoms are masked by the type -1 and have no neighbors
+      const int nloc_padded = shape_bucketing.nloc_padded;
+      const int nnei_padded = shape_bucketing.nnei_padded;
+      std::int64_t* nlist =
+          nlist_buffer.host(static_cast<int64_t>(nloc_padded) * nnei_padded,
+                            device);
+      std::fill(nlist, nlist + static_cast<size_t>(nloc_padded) * nnei_padded,
+                -1);
+      for (int ii = 0; ii < nloc_real; ii++) {
+        for (int jj = 0; jj < nnei; jj++) {
+          const int kk = nlist_data.jlist[ii][jj];
+          nlist[ii * nnei_padded + jj] =
+              kk < 0 ? -1 : shape_bucketing.padded_index(kk);
+        }
+      }
+      firstneigh_tensor = nlist_buffer.to_device({1, nloc_padded, nnei_padded});
+    } else {
+      // the neighbor list is unchanged until the next rebuild
+      firstneigh_tensor =
+          nlist_buffer.copy_from_nlist(nlist_data.jlist, device);
     }
     if (lmp_list.mapping) {
-      std::vector<std::int64_t> mapping(nall_real);
-      for (size_t ii = 0; ii < nall_real; ii++) {
-        mapping[ii] = lmp_list.mapping[fwd_map[ii]];
+      const int nall_padded =
+          bucketing ? shape_bucketing.nall_padded : nall_real;
+      std::int64_t* mapping = mapping_buffer.host(nall_padded, device);
+      std::fill(mapping, mapping + nall_padded, -1);
+      for (int ii = 0; ii < nall_real; ii++) {
+        // mapped indexes are local atoms, which are not moved by the padding
+        mapping[bucketing ? shape_bucketing.padded_index(ii) : ii] =
+            lmp_list.mapping[fwd_map[ii]];
+      }
+      if (bucketing) {
+        for (int ii = nloc_real; ii < shape_bucketing.nloc_padded; ii++) {
+          mapping[ii] = ii;
+        }
       }
-      mapping_tensor =
-          torch::from_blob(mapping.data(), {1, nall_real}, int_option)
-              .to(device);
+      mapping_tensor = mapping_buffer.to_device({1, nall_padded});
     }
   }
-  at::Tensor firstneigh = createNlistTensor(nlist_data.jlist);
-  firstneigh_tensor = firstneigh.to(torch::kInt64).to(device);
-  bool do_atom_virial_tensor = atomic;
+  TorchInputWorkspace<VALUETYPE>& ws = workspace<VALUETYPE>();
+  at::Tensor coord_wrapped_Tensor, atype_Tensor;
+  c10::optional<torch::Tensor> aparam_tensor;
+  // map from the rows of the outputs to all atoms; empty for identity
+  std::vector<int> out_map;
+  if (bucketing) {
+    const int nloc_padded = shape_bucketing.nloc_padded;
+    const int nall_padded = shape_bucketing.nall_padded;
+    VALUETYPE* coord_padded = ws.coord.host(nall_padded * 3, device);
+    std::int64_t* atype_padded = ws.atype.host(nall_padded, device);
+    std::fill(coord_padded, coord_padded + nall_padded * 3,
+              static_cast<VALUETYPE>(0));
+    std::fill(atype_padded, atype_padded + nall_padded, -1);
+    out_map.assign(nall_padded, -1);
+    for (int ii = 0; ii < nall_real; ii++) {
+      const int jj = shape_bucketing.padded_index(ii);
+      std::copy(&dcoord[ii * 3], &dcoord[ii * 3] + 3, &coord_padded[jj * 3]);
+      atype_padded[jj] = datype[ii];
+      out_map[jj] = bkw_map[ii];
+    }
+    coord_wrapped_Tensor = ws.coord.to_device({1, nall_padded, 3});
+    atype_Tensor = ws.atype.to_device({1, nall_padded});
+    if (!aparam_.empty()) {
+      const int na_real = aparam_nall ? nall_real : nloc_real;
+      const int na_padded = aparam_nall ? nall_padded : nloc_padded;
+      VALUETYPE* aparam_padded = ws.aparam.host(na_padded * daparam, device);
+      std::fill(aparam_padded, aparam_padded + na_padded * daparam,
+                static_cast<VALUETYPE>(0));
+      for (int ii = 0; ii < na_real; ii++) {
+        std::copy(&aparam_[ii * daparam], &aparam_[ii * daparam] + daparam,
+                  &aparam_padded[shape_bucketing.padded_index(ii) * daparam]);
+      }
+      aparam_tensor = ws.aparam.to_device({1, na_padded, daparam});
+    }
+  } else {
+    coord_wrapped_Tensor =
+        ws.coord.copy_from(dcoord.data(), {1, nall_real, 3}, device);
+    atype_Tensor = ws.atype.copy_from(datype.data(), {1, nall_real}, device);
+    if (!aparam_.empty()) {
+      aparam_tensor = ws.aparam.copy_from(
+          aparam_.data(),
+          {1, lmp_list.inum,
+           static_cast<std::int64_t>(aparam_.size()) / lmp_list.inum},
+          device);
+    }
+    if (nall_real != nall) {
+      out_map = bkw_map;
+    }
+  }
+  // the correction of the atomic virial takes three more backward passes, so
+  // it is only requested when the atomic virial is returned
+  bool do_atom_virial_tensor = atomic && atom_virial;
   c10::optional<torch::Tensor> fparam_tensor;
   if (!fparam.empty()) {
-    fparam_tensor =
-        torch::from_blob(const_cast<VALUETYPE*>(fparam.data()),
-                         {1, static_cast<std::int64_t>(fparam.size())}, options)
-            .to(device);
-  }
-  c10::optional<torch::Tensor> aparam_tensor;
-  if (!aparam_.empty()) {
-    aparam_tensor =
-        torch::from_blob(
-            const_cast<VALUETYPE*>(aparam_.data()),
-            {1, lmp_list.inum,
-             static_cast<std::int64_t>(aparam_.size()) / lmp_list.inum},
-            options)
-            .to(device);
+    fparam_tensor = ws.fparam.copy_from(
+        fparam.data(), {1, static_cast<std::int64_t>(fparam.size())}, device);
   }
   c10::Dict<c10::IValue, c10::IValue> outputs =
       (do_message_passing)
@@ -248,49 +449,135 @@ void DeepPotPT::compute(ENERGYVTYPE& ener,
                 .toGenericDict();
   c10::IValue energy_ = outputs.at("energy");
   c10::IValue force_ = outputs.at("extended_force");
-  c10::IValue virial_ = outputs.at("virial");
   torch::Tensor flat_energy_ = energy_.toTensor().view({-1});
   torch::Tensor cpu_energy_ = flat_energy_.to(torch::kCPU);
   ener.assign(cpu_energy_.data_ptr<ENERGYTYPE>(),
               cpu_energy_.data_ptr<ENERGYTYPE>() + cpu_energy_.numel());
-  torch::Tensor flat_force_ = force_.toTensor().view({-1}).to(floatType);
-  torch::Tensor cpu_force_ = flat_force_.to(torch::kCPU);
-  dforce.assign(cpu_force_.data_ptr<VALUETYPE>(),
-                cpu_force_.data_ptr<VALUETYPE>() + cpu_force_.numel());
-  torch::Tensor flat_virial_ = virial_.toTensor().view({-1}).to(floatType);
-  torch::Tensor cpu_virial_ = flat_virial_.to(torch::kCPU);
-  virial.assign(cpu_virial_.data_ptr<VALUETYPE>(),
-                cpu_virial_.data_ptr<VALUETYPE>() + cpu_virial_.numel());
-
+  // the exported model always returns the virial, which costs little more
+  // than the force, so only the transfer is skipped if it is not requested
+  if (virial) {
+    c10::IValue virial_ = outputs.at("virial");
+    torch::from_blob(virial, {9}, options)
+        .copy_(virial_.toTensor().view({-1}));
+  }
   // bkw map
-  force.resize(static_cast<size_t>(nframes) * fwd_map.size() * 3);
-  select_map<VALUETYPE>(force, dforce, bkw_map, 3, nframes, fwd_map.size(),
-                        nall_real);
+  copy_to_buffer<VALUETYPE>(force, force_.toTensor(), out_map, 3, nall);
   if (atomic) {
     c10::IValue atom_virial_ = outputs.at("extended_virial");
     c10::IValue atom_energy_ = outputs.at("atom_energy");
-    torch::Tensor flat_atom_energy_ =
-        atom_energy_.toTensor().view({-1}).to(floatType);
-    torch::Tensor cpu_atom_energy_ = flat_atom_energy_.to(torch::kCPU);
-    datom_energy.resize(nall_real,
-                        0.0);  // resize to nall to be consistenet with TF.
-    datom_energy.assign(
-        cpu_atom_energy_.data_ptr<VALUETYPE>(),
-        cpu_atom_energy_.data_ptr<VALUETYPE>() + cpu_atom_energy_.numel());
-    torch::Tensor flat_atom_virial_ =
-        atom_virial_.toTensor().view({-1}).to(floatType);
-    torch::Tensor cpu_atom_virial_ = flat_atom_virial_.to(torch::kCPU);
-    datom_virial.assign(
-        cpu_atom_virial_.data_ptr<VALUETYPE>(),
-        cpu_atom_virial_.data_ptr<VALUETYPE>() + cpu_atom_virial_.numel());
-    atom_energy.resize(static_cast<size_t>(nframes) * fwd_map.size());
-    atom_virial.resize(static_cast<size_t>(nframes) * fwd_map.size() * 9);
-    select_map<VALUETYPE>(atom_energy, datom_energy, bkw_map, 1, nframes,
-                          fwd_map.size(), nall_real);
-    select_map<VALUETYPE>(atom_virial, datom_virial, bkw_map, 9, nframes,
-                          fwd_map.size(), nall_real);
+    // atom_energy only contains local atoms; ghost atoms are set to zero to be
+    // consistent with TF.
+    copy_to_buffer<VALUETYPE>(atom_energy, atom_energy_.toTensor(), out_map, 1,
+                              nall);
+    if (atom_virial) {
+      copy_to_buffer<VALUETYPE>(atom_virial, atom_virial_.toTensor(), out_map,
+                                9, nall);
+    }
   }
 }
+template <typename VALUETYPE>
+void DeepPotPT::run_warmup(const InputNlist& lmp_list) {
+  std::vector<std::array<int, 3>> shapes;
+  shapes.swap(pending_warmup_shapes);
+  // the profiling executor needs a few runs to specialize and fuse a graph
+  const int nruns = 3;
+  // message passing models get the communicator of the actual call and no
+  // swaps, so nothing is exchanged; the actual call, which rebuilds the
+  // neighbor list, replaces the swaps afterwards
+  int no_swap = 0;
+  int* no_sendlist = &no_swap;
+  for (const auto& shape : shapes) {
+    const int nloc = shape[0], nall = shape[1], nnei = shape[2];
+    // place atoms on a simple cubic lattice with a spacing of rcut / 2 so
+    // that all atoms are separated and most neighbors are within the cutoff
+    const int nside = static_cast<int>(std::ceil(std::cbrt(nall)));
+    std::vector<VALUETYPE> coord(static_cast<size_t>(nall) * 3);
+    for (int ii = 0; ii < nall; ++ii) {
+      coord[ii * 3 + 0] = (ii % nside) * rcut / 2.;
+      coord[ii * 3 + 1] = ((ii / nside) % nside) * rcut / 2.;
+      coord[ii * 3 + 2] = (ii / (nside * nside)) * rcut / 2.;
+    }
+    std::vector<int> atype(nall, 0);
+    std::vector<VALUETYPE> box;
+    // distinct neighbors other than the atom itself; the rows are padded with
+    // -1 up to nnei by the compute path
+    const int nnei_real = std::min(nnei, nall - 1);
+    std::vector<int> ilist(nloc), numneigh(nloc, nnei_real);
+    std::vector<std::vector<int>> jlist(nloc, std::vector<int>(nnei_real));
+    std::vector<int*> firstneigh(nloc);
+    for (int ii = 0; ii < nloc; ++ii) {
+      ilist[ii] = ii;
+      for (int jj = 0; jj < nnei_real; ++jj) {
+        jlist[ii][jj] = (ii + jj + 1) % nall;
+      }
+      firstneigh[ii] = jlist[ii].data();
+    }
+    InputNlist nlist(nloc, ilist.data(), numneigh.data(), firstneigh.data(), 0,
+                     &no_swap, &no_swap, &no_swap, &no_sendlist, &no_swap,
+                     &no_swap, lmp_list.world);
+    std::vector<int> mapping;
+    if (lmp_list.mapping) {
+      mapping.resize(nall);
+      for (int ii = 0; ii < nall; ++ii) {
+        mapping[ii] = ii % nloc;
+      }
+      nlist.set_mapping(mapping.data());
+    }
+    std::vector<VALUETYPE> fparam(dfparam, 0.);
+    std::vector<VALUETYPE> aparam(
+        static_cast<size_t>(aparam_nall ? nall : nloc) * daparam, 0.);
+    std::vector<ENERGYTYPE> ener;
+    std::vector<VALUETYPE> force(static_cast<size_t>(nall) * 3), virial(9);
+    // the buckets are chosen as for the first call of a fresh model
+    ShapeBucketing actual_bucketing = shape_bucketing;
+    shape_bucketing = ShapeBucketing();
+    warmup_nnei = nnei;
+    auto t_start = std::chrono::steady_clock::now();
+    for (int ii = 0; ii < nruns; ++ii) {
+      compute(ener, force.data(), virial.data(), (VALUETYPE*)nullptr,
+              (VALUETYPE*)nullptr, coord, atype, box, nall - nloc, nlist, 0,
+              fparam, aparam, false);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - t_start;
+    warmup_nnei = 0;
+    shape_bucketing = actual_bucketing;
+    warmup_shapes.push_back(shape);
+    if (is_first_rank()) {
+      std::cout << "DeePMD-kit: warm up PyTorch model with nloc=" << nloc
+                << ", nall=" << nall << ", nnei=" << nnei << " in "
+                << elapsed.count() << " s" << std::endl;
+    }
+  }
+}
+
+template <typename VALUETYPE, typename ENERGYVTYPE>
+void DeepPotPT::compute(ENERGYVTYPE& ener,
+                        std::vector<VALUETYPE>& force,
+                        std::vector<VALUETYPE>& virial,
+                        std::vector<VALUETYPE>& atom_energy,
+                        std::vector<VALUETYPE>& atom_virial,
+                        const std::vector<VALUETYPE>& coord,
+                        const std::vector<int>& atype,
+                        const std::vector<VALUETYPE>& box,
+                        const int nghost,
+                        const InputNlist& lmp_list,
+                        const int& ago,
+                        const std::vector<VALUETYPE>& fparam,
+                        const std::vector<VALUETYPE>& aparam,
+                        const bool atomic) {
+  const size_t nall = atype.size();
+  force.resize(nall * 3);
+  virial.resize(9);
+  if (atomic) {
+    atom_energy.resize(nall);
+    atom_virial.resize(nall * 9);
+  }
+  compute(ener, force.data(), virial.data(),
+          atomic ? atom_energy.data() : nullptr,
+          atomic ? atom_virial.data() : nullptr, coord, atype, box, nghost,
+          lmp_list, ago, fparam, aparam, atomic);
+}
 template void DeepPotPT::compute<double, std::vector<ENERGYTYPE>>(
     std::vector<ENERGYTYPE>& ener,
     std::vector<double>& force,
@@ -333,52 +620,41 @@ void DeepPotPT::compute(ENERGYVTYPE& ener,
                         const std::vector<VALUETYPE>& fparam,
                         const std::vector<VALUETYPE>& aparam,
                         const bool atomic) {
+  apply_nthreads();
   torch::Device device(torch::kCUDA, gpu_id);
   if (!gpu_enabled) {
     device = torch::Device(torch::kCPU);
   }
-  std::vector<VALUETYPE> coord_wrapped = coord;
   int natoms = atype.size();
-  auto options = torch::TensorOptions().dtype(torch::kFloat64);
   torch::ScalarType floatType = torch::kFloat64;
   if (std::is_same<VALUETYPE, float>::value) {
-    options = torch::TensorOptions().dtype(torch::kFloat32);
     floatType = torch::kFloat32;
   }
-  auto int_options = torch::TensorOptions().dtype(torch::kInt64);
-  int nframes = 1;
+  TorchInputWorkspace<VALUETYPE>& ws = workspace<VALUETYPE>();
   std::vector<torch::jit::IValue> inputs;
   at::Tensor coord_wrapped_Tensor =
-      torch::from_blob(coord_wrapped.data(), {1, natoms, 3}, options)
-          .to(device);
+      ws.coord.copy_from(coord.data(), {1, natoms, 3}, device);
   inputs.push_back(coord_wrapped_Tensor);
-  std::vector<std::int64_t> atype_64(atype.begin(), atype.end());
   at::Tensor atype_Tensor =
-      torch::from_blob(atype_64.data(), {1, natoms}, int_options).to(device);
+      ws.atype.copy_from(atype.data(), {1, natoms}, device);
   inputs.push_back(atype_Tensor);
   c10::optional<torch::Tensor> box_Tensor;
   if (!box.empty()) {
-    box_Tensor =
-        torch::from_blob(const_cast<VALUETYPE*>(box.data()), {1, 9}, options)
-            .to(device);
+    box_Tensor = ws.box.copy_from(box.data(), {1, 9}, device);
   }
   inputs.push_back(box_Tensor);
   c10::optional<torch::Tensor> fparam_tensor;
   if (!fparam.empty()) {
-    fparam_tensor =
-        torch::from_blob(const_cast<VALUETYPE*>(fparam.data()),
-                         {1, static_cast<std::int64_t>(fparam.size())}, options)
-            .to(device);
+    fparam_tensor = ws.fparam.copy_from(
+        fparam.data(), {1, static_cast<std::int64_t>(fparam.size())}, device);
   }
   inputs.push_back(fparam_tensor);
   c10::optional<torch::Tensor> aparam_tensor;
   if (!aparam.empty()) {
-    aparam_tensor =
-        torch::from_blob(
-            const_cast<VALUETYPE*>(aparam.data()),
-            {1, natoms, static_cast<std::int64_t>(aparam.size()) / natoms},
-            options)
-            .to(device);
+    aparam_tensor = ws.aparam.copy_from(
+        aparam.data(),
+        {1, natoms, static_cast<std::int64_t>(aparam.size()) / natoms},
+        device);
   }
   inputs.push_back(aparam_tensor);
   bool do_atom_virial_tensor = atomic;
@@ -521,6 +797,44 @@ void DeepPotPT::computew(std::vector<double>& ener,
             nghost, inlist, ago, fparam, aparam, atomic);
   });
 }
+void DeepPotPT::computew_buffer(std::vector<double>& ener,
+                                double* force,
+                                double* virial,
+                                double* atom_energy,
+                                double* atom_virial,
+                                const std::vector<double>& coord,
+                                const std::vector<int>& atype,
+                                const std::vector<double>& box,
+                                const int nghost,
+                                const InputNlist& inlist,
+                                const int& ago,
+                                const std::vector<double>& fparam,
+                                const std::vector<double>& aparam,
+                                const bool atomic) {
+  translate_error([&] {
+    compute(ener, force, virial, atom_energy, atom_virial, coord, atype, box,
+            nghost, inlist, ago, fparam, aparam, atomic);
+  });
+}
+void DeepPotPT::computew_buffer(std::vector<double>& ener,
+                                float* force,
+                                float* virial,
+                                float* atom_energy,
+                                float* atom_virial,
+                                const std::vector<float>& coord,
+                                const std::vector<int>& atype,
+                                const std::vector<float>& box,
+                                const int nghost,
+                                const InputNlist& inlist,
+                                const int& ago,
+                                const std::vector<float>& fparam,
+                                const std::vector<float>& aparam,
+                                const bool atomic) {
+  translate_error([&] {
+    compute(ener, force, virial, atom_energy, atom_virial, coord, atype, box,
+            nghost, inlist, ago, fparam, aparam, atomic);
+  });
+}
 void DeepPotPT::computew_mixed_type(std::vector<double>& ener,
                                     std::vector<double>& force,
                                     std::vector<double>& virial,
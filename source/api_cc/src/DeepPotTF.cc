@@ -2,12 +2,14 @@
 #ifdef BUILD_TENSORFLOW
 #include "DeepPotTF.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <stdexcept>
 
 #include "AtomMap.h"
 #include "common.h"
 #include "device.h"
+#include "tensorflow/core/util/memmapped_file_system.h"
 
 using namespace tensorflow;
 using namespace deepmd;
@@ -19,11 +21,12 @@ static void run_model(
     std::vector<ENERGYTYPE>& dener,
     std::vector<VALUETYPE>& dforce_,
     std::vector<VALUETYPE>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
-    const int nghost = 0) {
+    const int nghost = 0,
+    const bool need_virial = true) {
   unsigned nloc = atommap.get_type().size();
   unsigned nall = nloc + nghost;
   dener.resize(nframes);
@@ -38,18 +41,20 @@ static void run_model(
     return;
   }
 
+  // the atomic virial is only fetched if the virial is requested, so that
+  // the session does not evaluate the virial nodes
+  std::vector<std::string> output_names = {"o_energy", "o_force"};
+  if (need_virial) {
+    output_names.push_back("o_atom_virial");
+  }
   std::vector<Tensor> output_tensors;
-  check_status(session->Run(
-      input_tensors, {"o_energy", "o_force", "o_atom_energy", "o_atom_virial"},
-      {}, &output_tensors));
+  callables.run(input_tensors, output_names, &output_tensors);
 
   Tensor output_e = output_tensors[0];
   Tensor output_f = output_tensors[1];
-  Tensor output_av = output_tensors[3];
 
   auto oe = output_e.flat<ENERGYTYPE>();
   auto of = output_f.flat<MODELTYPE>();
-  auto oav = output_av.flat<MODELTYPE>();
 
   std::vector<VALUETYPE> dforce(static_cast<size_t>(nframes) * 3 * nall);
   dvirial.resize(static_cast<size_t>(nframes) * 9);
@@ -61,6 +66,13 @@ static void run_model(
   }
   // set dvirial to zero, prevent input vector is not zero (#1123)
   std::fill(dvirial.begin(), dvirial.end(), (VALUETYPE)0.);
+  if (!need_virial) {
+    dforce_ = dforce;
+    atommap.backward<VALUETYPE>(dforce_.begin(), dforce.begin(), 3, nframes,
+                                nall);
+    return;
+  }
+  auto oav = output_tensors[2].flat<MODELTYPE>();
   for (int kk = 0; kk < nframes; ++kk) {
     for (int ii = 0; ii < nall; ++ii) {
       dvirial[kk * 9 + 0] += (VALUETYPE)1.0 * oav(kk * nall * 9 + 9 * ii + 0);
@@ -83,41 +95,45 @@ template void run_model<double, double>(
     std::vector<ENERGYTYPE>& dener,
     std::vector<double>& dforce_,
     std::vector<double>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
-    const int nghost);
+    const int nghost,
+    const bool need_virial);
 
 template void run_model<double, float>(
     std::vector<ENERGYTYPE>& dener,
     std::vector<float>& dforce_,
     std::vector<float>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
-    const int nghost);
+    const int nghost,
+    const bool need_virial);
 
 template void run_model<float, double>(
     std::vector<ENERGYTYPE>& dener,
     std::vector<double>& dforce_,
     std::vector<double>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
-    const int nghost);
+    const int nghost,
+    const bool need_virial);
 
 template void run_model<float, float>(
     std::vector<ENERGYTYPE>& dener,
     std::vector<float>& dforce_,
     std::vector<float>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
-    const int nghost);
+    const int nghost,
+    const bool need_virial);
 
 template <typename MODELTYPE, typename VALUETYPE>
 static void run_model(
@@ -126,7 +142,7 @@ static void run_model(
     std::vector<VALUETYPE>& dvirial,
     std::vector<VALUETYPE>& datom_energy_,
     std::vector<VALUETYPE>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -152,9 +168,9 @@ static void run_model(
   }
   std::vector<Tensor> output_tensors;
 
-  check_status(session->Run(
-      input_tensors, {"o_energy", "o_force", "o_atom_energy", "o_atom_virial"},
-      {}, &output_tensors));
+  callables.run(input_tensors,
+                {"o_energy", "o_force", "o_atom_energy", "o_atom_virial"},
+                &output_tensors);
 
   Tensor output_e = output_tensors[0];
   Tensor output_f = output_tensors[1];
@@ -225,7 +241,7 @@ template void run_model<double, double>(
     std::vector<double>& dvirial,
     std::vector<double>& datom_energy_,
     std::vector<double>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -237,7 +253,7 @@ template void run_model<double, float>(
     std::vector<float>& dvirial,
     std::vector<float>& datom_energy_,
     std::vector<float>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -249,7 +265,7 @@ template void run_model<float, double>(
     std::vector<double>& dvirial,
     std::vector<double>& datom_energy_,
     std::vector<double>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -261,7 +277,7 @@ template void run_model<float, float>(
     std::vector<float>& dvirial,
     std::vector<float>& datom_energy_,
     std::vector<float>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -276,16 +292,18 @@ static void run_model(
     ENERGYTYPE& dener,
     std::vector<VALUETYPE>& dforce_,
     std::vector<VALUETYPE>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes = 1,
-    const int nghost = 0) {
+    const int nghost = 0,
+    const bool need_virial = true) {
   assert(nframes == 1);
   std::vector<ENERGYTYPE> dener_(1);
   // call multi-frame version
-  run_model<MODELTYPE, VALUETYPE>(dener_, dforce_, dvirial, session,
-                                  input_tensors, atommap, nframes, nghost);
+  run_model<MODELTYPE, VALUETYPE>(dener_, dforce_, dvirial, callables,
+                                  input_tensors, atommap, nframes, nghost,
+                                  need_virial);
   dener = dener_[0];
 }
 
@@ -293,41 +311,45 @@ template void run_model<double, double>(
     ENERGYTYPE& dener,
     std::vector<double>& dforce_,
     std::vector<double>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
-    const int nghost);
+    const int nghost,
+    const bool need_virial);
 
 template void run_model<double, float>(
     ENERGYTYPE& dener,
     std::vector<float>& dforce_,
     std::vector<float>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
-    const int nghost);
+    const int nghost,
+    const bool need_virial);
 
 template void run_model<float, double>(
     ENERGYTYPE& dener,
     std::vector<double>& dforce_,
     std::vector<double>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
-    const int nghost);
+    const int nghost,
+    const bool need_virial);
 
 template void run_model<float, float>(
     ENERGYTYPE& dener,
     std::vector<float>& dforce_,
     std::vector<float>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
-    const int nghost);
+    const int nghost,
+    const bool need_virial);
 
 template <typename MODELTYPE, typename VALUETYPE>
 static void run_model(
@@ -336,7 +358,7 @@ static void run_model(
     std::vector<VALUETYPE>& dvirial,
     std::vector<VALUETYPE>& datom_energy_,
     std::vector<VALUETYPE>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes = 1,
@@ -345,7 +367,7 @@ static void run_model(
   std::vector<ENERGYTYPE> dener_(1);
   // call multi-frame version
   run_model<MODELTYPE, VALUETYPE>(dener_, dforce_, dvirial, datom_energy_,
-                                  datom_virial_, session, input_tensors,
+                                  datom_virial_, callables, input_tensors,
                                   atommap, nframes, nghost);
   dener = dener_[0];
 }
@@ -356,7 +378,7 @@ template void run_model<double, double>(
     std::vector<double>& dvirial,
     std::vector<double>& datom_energy_,
     std::vector<double>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -368,7 +390,7 @@ template void run_model<double, float>(
     std::vector<float>& dvirial,
     std::vector<float>& datom_energy_,
     std::vector<float>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -380,7 +402,7 @@ template void run_model<float, double>(
     std::vector<double>& dvirial,
     std::vector<double>& datom_energy_,
     std::vector<double>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -392,7 +414,7 @@ template void run_model<float, float>(
     std::vector<float>& dvirial,
     std::vector<float>& datom_energy_,
     std::vector<float>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -431,13 +453,37 @@ void DeepPotTF::init(const std::string& model,
   get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
   options.config.set_inter_op_parallelism_threads(num_inter_nthreads);
   options.config.set_intra_op_parallelism_threads(num_intra_nthreads);
-  deepmd::load_op_library();
-
-  if (file_content.size() == 0) {
+  InitTimer timer;
+
+  if (is_memmapped_model(model)) {
+    // the constants are mapped from the file instead of being copied into
+    // the graph, so the processes on a node share the pages of the weights
+    std::unique_ptr<MemmappedEnv> memmapped_env(
+        new MemmappedEnv(Env::Default()));
+    check_status(memmapped_env->InitializeFromFile(model));
+    check_status(ReadBinaryProto(
+        memmapped_env.get(),
+        MemmappedFileSystem::kMemmappedPackageDefaultGraphDef, graph_def));
+    options.env = memmapped_env.get();
+    // constant folding would copy the mapped constants
+    options.config.mutable_graph_options()
+        ->mutable_optimizer_options()
+        ->set_opt_level(OptimizerOptions::L0);
+    model_env = std::move(memmapped_env);
+  } else if (file_content.size() == 0) {
     check_status(ReadBinaryProto(Env::Default(), model, graph_def));
   } else {
     (*graph_def).ParseFromString(file_content);
   }
+  timer.record("read graph");
+  // the OP library is only needed by graphs using the customized OPs, while
+  // the plugins are always loaded
+  if (has_unregistered_ops(*graph_def)) {
+    deepmd::load_op_library(DPBackend::TensorFlow);
+  } else {
+    deepmd::load_plugin_library();
+  }
+  timer.record("load OP library");
   int gpu_num = -1;
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
   DPGetDeviceCount(gpu_num);  // check current device environment
@@ -457,6 +503,8 @@ void DeepPotTF::init(const std::string& model,
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
   check_status(NewSession(options, &session));
   check_status(session->Create(*graph_def));
+  callables.reset(session);
+  timer.record("import graph");
   try {
     model_version = get_scalar<STRINGTYPE>("model_attr/model_version");
   } catch (deepmd::tf_exception& e) {
@@ -500,6 +548,7 @@ void DeepPotTF::init(const std::string& model,
   inited = true;
 
   init_nbor = false;
+  timer.report(model);
 }
 
 template <class VT>
@@ -507,6 +556,17 @@ VT DeepPotTF::get_scalar(const std::string& name) const {
   return session_get_scalar<VT>(session, name);
 }
 
+void DeepPotTF::update_atommap(
+    const std::vector<int>::const_iterator type_begin,
+    const std::vector<int>::const_iterator type_end) {
+  if (atommap_type.size() == static_cast<size_t>(type_end - type_begin) &&
+      std::equal(type_begin, type_end, atommap_type.begin())) {
+    return;
+  }
+  atommap = deepmd::AtomMap(type_begin, type_end);
+  atommap_type.assign(type_begin, type_end);
+}
+
 template <typename VALUETYPE>
 void DeepPotTF::validate_fparam_aparam(
     const int& nframes,
@@ -584,7 +644,7 @@ void DeepPotTF::compute(ENERGYVTYPE& dener,
                         const bool atomic) {
   // if datype.size is 0, not clear nframes; but 1 is just ok
   int nframes = datype_.size() > 0 ? (dcoord_.size() / 3 / datype_.size()) : 1;
-  atommap = deepmd::AtomMap(datype_.begin(), datype_.end());
+  update_atommap(datype_.begin(), datype_.end());
   int nloc = datype_.size();
   std::vector<VALUETYPE> fparam;
   std::vector<VALUETYPE> aparam;
@@ -600,9 +660,9 @@ void DeepPotTF::compute(ENERGYVTYPE& dener,
                                             aparam, atommap, "", aparam_nall);
     if (atomic) {
       run_model<double>(dener, dforce_, dvirial, datom_energy_, datom_virial_,
-                        session, input_tensors, atommap, nframes);
+                        callables, input_tensors, atommap, nframes);
     } else {
-      run_model<double>(dener, dforce_, dvirial, session, input_tensors,
+      run_model<double>(dener, dforce_, dvirial, callables, input_tensors,
                         atommap, nframes);
     }
   } else {
@@ -611,10 +671,10 @@ void DeepPotTF::compute(ENERGYVTYPE& dener,
                                            aparam, atommap, "", aparam_nall);
     if (atomic) {
       run_model<float>(dener, dforce_, dvirial, datom_energy_, datom_virial_,
-                       session, input_tensors, atommap, nframes);
+                       callables, input_tensors, atommap, nframes);
     } else {
-      run_model<float>(dener, dforce_, dvirial, session, input_tensors, atommap,
-                       nframes);
+      run_model<float>(dener, dforce_, dvirial, callables, input_tensors,
+                       atommap, nframes);
     }
   }
 }
@@ -685,7 +745,8 @@ void DeepPotTF::compute(ENERGYVTYPE& dener,
                         const int& ago,
                         const std::vector<VALUETYPE>& fparam_,
                         const std::vector<VALUETYPE>& aparam__,
-                        const bool atomic) {
+                        const bool atomic,
+                        const bool need_virial) {
   int nall = datype_.size();
   // if nall==0, unclear nframes, but 1 is ok
   int nframes = nall > 0 ? (dcoord_.size() / nall / 3) : 1;
@@ -707,7 +768,9 @@ void DeepPotTF::compute(ENERGYVTYPE& dener,
                           nghost, ntypes, nframes, daparam, nall, aparam_nall);
 
   if (ago == 0) {
-    atommap = deepmd::AtomMap(datype.begin(), datype.begin() + nloc_real);
+    // the local atoms may have been exchanged, but the map only depends on
+    // their types, so it is kept if the types are unchanged
+    update_atommap(datype.begin(), datype.begin() + nloc_real);
     assert(nloc_real == atommap.get_type().size());
 
     nlist_data.copy_from_nlist(lmp_list);
@@ -723,10 +786,11 @@ void DeepPotTF::compute(ENERGYVTYPE& dener,
     assert(nloc_real == ret);
     if (atomic) {
       run_model<double>(dener, dforce, dvirial, datom_energy, datom_virial,
-                        session, input_tensors, atommap, nframes, nghost_real);
+                        callables, input_tensors, atommap, nframes,
+                        nghost_real);
     } else {
-      run_model<double>(dener, dforce, dvirial, session, input_tensors, atommap,
-                        nframes, nghost_real);
+      run_model<double>(dener, dforce, dvirial, callables, input_tensors,
+                        atommap, nframes, nghost_real, need_virial);
     }
   } else {
     int ret = session_input_tensors<float>(
@@ -735,10 +799,10 @@ void DeepPotTF::compute(ENERGYVTYPE& dener,
     assert(nloc_real == ret);
     if (atomic) {
       run_model<float>(dener, dforce, dvirial, datom_energy, datom_virial,
-                       session, input_tensors, atommap, nframes, nghost_real);
+                       callables, input_tensors, atommap, nframes, nghost_real);
     } else {
-      run_model<float>(dener, dforce, dvirial, session, input_tensors, atommap,
-                       nframes, nghost_real);
+      run_model<float>(dener, dforce, dvirial, callables, input_tensors,
+                       atommap, nframes, nghost_real, need_virial);
     }
   }
 
@@ -768,7 +832,8 @@ template void DeepPotTF::compute<double, ENERGYTYPE>(
     const int& ago,
     const std::vector<double>& fparam,
     const std::vector<double>& aparam_,
-    const bool atomic);
+    const bool atomic,
+    const bool need_virial);
 
 template void DeepPotTF::compute<float, ENERGYTYPE>(
     ENERGYTYPE& dener,
@@ -784,7 +849,8 @@ template void DeepPotTF::compute<float, ENERGYTYPE>(
     const int& ago,
     const std::vector<float>& fparam,
     const std::vector<float>& aparam_,
-    const bool atomic);
+    const bool atomic,
+    const bool need_virial);
 
 template void DeepPotTF::compute<double, std::vector<ENERGYTYPE>>(
     std::vector<ENERGYTYPE>& dener,
@@ -800,7 +866,8 @@ template void DeepPotTF::compute<double, std::vector<ENERGYTYPE>>(
     const int& ago,
     const std::vector<double>& fparam,
     const std::vector<double>& aparam_,
-    const bool atomic);
+    const bool atomic,
+    const bool need_virial);
 
 template void DeepPotTF::compute<float, std::vector<ENERGYTYPE>>(
     std::vector<ENERGYTYPE>& dener,
@@ -816,7 +883,8 @@ template void DeepPotTF::compute<float, std::vector<ENERGYTYPE>>(
     const int& ago,
     const std::vector<float>& fparam,
     const std::vector<float>& aparam_,
-    const bool atomic);
+    const bool atomic,
+    const bool need_virial);
 
 // mixed type
 
@@ -835,7 +903,7 @@ void DeepPotTF::compute_mixed_type(ENERGYVTYPE& dener,
                                    const bool atomic) {
   int nloc = datype_.size() / nframes;
   // here atommap only used to get nloc
-  atommap = deepmd::AtomMap(datype_.begin(), datype_.begin() + nloc);
+  update_atommap(datype_.begin(), datype_.begin() + nloc);
   std::vector<VALUETYPE> fparam;
   std::vector<VALUETYPE> aparam;
   validate_fparam_aparam(nframes, nloc, fparam_, aparam_);
@@ -850,9 +918,9 @@ void DeepPotTF::compute_mixed_type(ENERGYVTYPE& dener,
         fparam, aparam, atommap, "", aparam_nall);
     if (atomic) {
       run_model<double>(dener, dforce_, dvirial, datom_energy_, datom_virial_,
-                        session, input_tensors, atommap, nframes);
+                        callables, input_tensors, atommap, nframes);
     } else {
-      run_model<double>(dener, dforce_, dvirial, session, input_tensors,
+      run_model<double>(dener, dforce_, dvirial, callables, input_tensors,
                         atommap, nframes);
     }
   } else {
@@ -861,10 +929,10 @@ void DeepPotTF::compute_mixed_type(ENERGYVTYPE& dener,
         fparam, aparam, atommap, "", aparam_nall);
     if (atomic) {
       run_model<float>(dener, dforce_, dvirial, datom_energy_, datom_virial_,
-                       session, input_tensors, atommap, nframes);
+                       callables, input_tensors, atommap, nframes);
     } else {
-      run_model<float>(dener, dforce_, dvirial, session, input_tensors, atommap,
-                       nframes);
+      run_model<float>(dener, dforce_, dvirial, callables, input_tensors,
+                       atommap, nframes);
     }
   }
 }
@@ -992,6 +1060,58 @@ void DeepPotTF::computew(std::vector<double>& ener,
   compute(ener, force, virial, atom_energy, atom_virial, coord, atype, box,
           nghost, inlist, ago, fparam, aparam, atomic);
 }
+void DeepPotTF::computew_buffer(std::vector<double>& ener,
+                                double* force,
+                                double* virial,
+                                double* atom_energy,
+                                double* atom_virial,
+                                const std::vector<double>& coord,
+                                const std::vector<int>& atype,
+                                const std::vector<double>& box,
+                                const int nghost,
+                                const InputNlist& inlist,
+                                const int& ago,
+                                const std::vector<double>& fparam,
+                                const std::vector<double>& aparam,
+                                const bool atomic) {
+  std::vector<double> force_, virial_, atom_energy_, atom_virial_;
+  compute(ener, force_, virial_, atom_energy_, atom_virial_, coord, atype, box,
+          nghost, inlist, ago, fparam, aparam, atomic, virial != nullptr);
+  std::copy(force_.begin(), force_.end(), force);
+  if (virial) {
+    std::copy(virial_.begin(), virial_.end(), virial);
+  }
+  if (atomic) {
+    std::copy(atom_energy_.begin(), atom_energy_.end(), atom_energy);
+    std::copy(atom_virial_.begin(), atom_virial_.end(), atom_virial);
+  }
+}
+void DeepPotTF::computew_buffer(std::vector<double>& ener,
+                                float* force,
+                                float* virial,
+                                float* atom_energy,
+                                float* atom_virial,
+                                const std::vector<float>& coord,
+                                const std::vector<int>& atype,
+                                const std::vector<float>& box,
+                                const int nghost,
+                                const InputNlist& inlist,
+                                const int& ago,
+                                const std::vector<float>& fparam,
+                                const std::vector<float>& aparam,
+                                const bool atomic) {
+  std::vector<float> force_, virial_, atom_energy_, atom_virial_;
+  compute(ener, force_, virial_, atom_energy_, atom_virial_, coord, atype, box,
+          nghost, inlist, ago, fparam, aparam, atomic, virial != nullptr);
+  std::copy(force_.begin(), force_.end(), force);
+  if (virial) {
+    std::copy(virial_.begin(), virial_.end(), virial);
+  }
+  if (atomic) {
+    std::copy(atom_energy_.begin(), atom_energy_.end(), atom_energy);
+    std::copy(atom_virial_.begin(), atom_virial_.end(), atom_virial);
+  }
+}
 void DeepPotTF::computew_mixed_type(std::vector<double>& ener,
                                     std::vector<double>& force,
                                     std::vector<double>& virial,
@@ -38,6 +38,7 @@ void DeepSpin::init(const std::string& model,
   }
   const DPBackend backend = get_backend(model);
   if (deepmd::DPBackend::TensorFlow == backend) {
+    reject_memmapped_model(model, "DeepSpin");
 #ifdef BUILD_TENSORFLOW
     dp = std::make_shared<deepmd::DeepSpinTF>(model, gpu_rank, file_content);
 #else
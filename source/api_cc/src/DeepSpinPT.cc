@@ -7,6 +7,7 @@
 #include <cstdint>
 
 #include "common.h"
+#include "commonPT.h"
 #include "device.h"
 #include "errors.h"
 
@@ -30,22 +31,16 @@ void DeepSpinPT::translate_error(std::function<void()> f) {
   }
 }
 
-torch::Tensor createNlistTensor2(const std::vector<std::vector<int>>& data) {
-  size_t total_size = 0;
-  for (const auto& row : data) {
-    total_size += row.size();
-  }
-  std::vector<int> flat_data;
-  flat_data.reserve(total_size);
-  for (const auto& row : data) {
-    flat_data.insert(flat_data.end(), row.begin(), row.end());
-  }
-
-  torch::Tensor flat_tensor = torch::tensor(flat_data, torch::kInt32);
-  int nloc = data.size();
-  int nnei = nloc > 0 ? total_size / nloc : 0;
-  return flat_tensor.view({1, nloc, nnei});
+namespace deepmd {
+template <>
+TorchInputWorkspace<double>& DeepSpinPT::workspace<double>() {
+  return workspace_double;
 }
+template <>
+TorchInputWorkspace<float>& DeepSpinPT::workspace<float>() {
+  return workspace_float;
+}
+}  // namespace deepmd
 DeepSpinPT::DeepSpinPT() : inited(false) {}
 DeepSpinPT::DeepSpinPT(const std::string& model,
                        const int& gpu_rank,
@@ -67,7 +62,7 @@ void DeepSpinPT::init(const std::string& model,
               << std::endl;
     return;
   }
-  deepmd::load_op_library();
+  deepmd::load_op_library(DPBackend::PyTorch);
   int gpu_num = torch::cuda::device_count();
   if (gpu_num > 0) {
     gpu_id = gpu_rank % gpu_num;
@@ -151,8 +146,6 @@ void DeepSpinPT::compute(ENERGYVTYPE& ener,
   }
   auto int32_option =
       torch::TensorOptions().device(torch::kCPU).dtype(torch::kInt32);
-  auto int_option =
-      torch::TensorOptions().device(torch::kCPU).dtype(torch::kInt64);
   // select real atoms
   std::vector<VALUETYPE> dcoord, dforce, dforce_mag, aparam_, datom_energy,
       datom_virial;
@@ -164,17 +157,13 @@ void DeepSpinPT::compute(ENERGYVTYPE& ener,
                           nghost, ntypes, 1, daparam, nall, aparam_nall);
   int nloc = nall_real - nghost_real;
   int nframes = 1;
-  std::vector<VALUETYPE> coord_wrapped = dcoord;
+  TorchInputWorkspace<VALUETYPE>& ws = workspace<VALUETYPE>();
   at::Tensor coord_wrapped_Tensor =
-      torch::from_blob(coord_wrapped.data(), {1, nall_real, 3}, options)
-          .to(device);
-  std::vector<VALUETYPE> spin_wrapped = spin;
+      ws.coord.copy_from(dcoord.data(), {1, nall_real, 3}, device);
   at::Tensor spin_wrapped_Tensor =
-      torch::from_blob(spin_wrapped.data(), {1, nall_real, 3}, options)
-          .to(device);
-  std::vector<std::int64_t> atype_64(datype.begin(), datype.end());
+      ws.spin.copy_from(spin.data(), {1, nall_real, 3}, device);
   at::Tensor atype_Tensor =
-      torch::from_blob(atype_64.data(), {1, nall_real}, int_option).to(device);
+      ws.atype.copy_from(datype.data(), {1, nall_real}, device);
   c10::optional<torch::Tensor> mapping_tensor;
   if (ago == 0) {
     nlist_data.copy_from_nlist(lmp_list, nall - nghost);
@@ -213,26 +202,22 @@ void DeepSpinPT::compute(ENERGYVTYPE& ener,
       comm_dict.insert("communicator", communicator_tensor);
       comm_dict.insert("has_spin", has_spin);
     }
+    // the neighbor list is unchanged until the next rebuild
+    firstneigh_tensor = nlist_buffer.copy_from_nlist(nlist_data.jlist, device);
   }
-  at::Tensor firstneigh = createNlistTensor2(nlist_data.jlist);
-  firstneigh_tensor = firstneigh.to(torch::kInt64).to(device);
   bool do_atom_virial_tensor = atomic;
   c10::optional<torch::Tensor> fparam_tensor;
   if (!fparam.empty()) {
-    fparam_tensor =
-        torch::from_blob(const_cast<VALUETYPE*>(fparam.data()),
-                         {1, static_cast<std::int64_t>(fparam.size())}, options)
-            .to(device);
+    fparam_tensor = ws.fparam.copy_from(
+        fparam.data(), {1, static_cast<std::int64_t>(fparam.size())}, device);
   }
   c10::optional<torch::Tensor> aparam_tensor;
   if (!aparam_.empty()) {
-    aparam_tensor =
-        torch::from_blob(
-            const_cast<VALUETYPE*>(aparam_.data()),
-            {1, lmp_list.inum,
-             static_cast<std::int64_t>(aparam_.size()) / lmp_list.inum},
-            options)
-            .to(device);
+    aparam_tensor = ws.aparam.copy_from(
+        aparam_.data(),
+        {1, lmp_list.inum,
+         static_cast<std::int64_t>(aparam_.size()) / lmp_list.inum},
+        device);
   }
   c10::Dict<c10::IValue, c10::IValue> outputs =
       (do_message_passing)
@@ -360,52 +345,40 @@ void DeepSpinPT::compute(ENERGYVTYPE& ener,
   if (!gpu_enabled) {
     device = torch::Device(torch::kCPU);
   }
-  std::vector<VALUETYPE> coord_wrapped = coord;
-  std::vector<VALUETYPE> spin_wrapped = spin;
   int natoms = atype.size();
-  auto options = torch::TensorOptions().dtype(torch::kFloat64);
   torch::ScalarType floatType = torch::kFloat64;
   if (std::is_same<VALUETYPE, float>::value) {
-    options = torch::TensorOptions().dtype(torch::kFloat32);
     floatType = torch::kFloat32;
   }
-  auto int_options = torch::TensorOptions().dtype(torch::kInt64);
   int nframes = 1;
+  TorchInputWorkspace<VALUETYPE>& ws = workspace<VALUETYPE>();
   std::vector<torch::jit::IValue> inputs;
   at::Tensor coord_wrapped_Tensor =
-      torch::from_blob(coord_wrapped.data(), {1, natoms, 3}, options)
-          .to(device);
+      ws.coord.copy_from(coord.data(), {1, natoms, 3}, device);
   inputs.push_back(coord_wrapped_Tensor);
-  std::vector<std::int64_t> atype_64(atype.begin(), atype.end());
   at::Tensor atype_Tensor =
-      torch::from_blob(atype_64.data(), {1, natoms}, int_options).to(device);
+      ws.atype.copy_from(atype.data(), {1, natoms}, device);
   inputs.push_back(atype_Tensor);
   at::Tensor spin_wrapped_Tensor =
-      torch::from_blob(spin_wrapped.data(), {1, natoms, 3}, options).to(device);
+      ws.spin.copy_from(spin.data(), {1, natoms, 3}, device);
   inputs.push_back(spin_wrapped_Tensor);
   c10::optional<torch::Tensor> box_Tensor;
   if (!box.empty()) {
-    box_Tensor =
-        torch::from_blob(const_cast<VALUETYPE*>(box.data()), {1, 9}, options)
-            .to(device);
+    box_Tensor = ws.box.copy_from(box.data(), {1, 9}, device);
   }
   inputs.push_back(box_Tensor);
   c10::optional<torch::Tensor> fparam_tensor;
   if (!fparam.empty()) {
-    fparam_tensor =
-        torch::from_blob(const_cast<VALUETYPE*>(fparam.data()),
-                         {1, static_cast<std::int64_t>(fparam.size())}, options)
-            .to(device);
+    fparam_tensor = ws.fparam.copy_from(
+        fparam.data(), {1, static_cast<std::int64_t>(fparam.size())}, device);
   }
   inputs.push_back(fparam_tensor);
   c10::optional<torch::Tensor> aparam_tensor;
   if (!aparam.empty()) {
-    aparam_tensor =
-        torch::from_blob(
-            const_cast<VALUETYPE*>(aparam.data()),
-            {1, natoms, static_cast<std::int64_t>(aparam.size()) / natoms},
-            options)
-            .to(device);
+    aparam_tensor = ws.aparam.copy_from(
+        aparam.data(),
+        {1, natoms, static_cast<std::int64_t>(aparam.size()) / natoms},
+        device);
   }
   inputs.push_back(aparam_tensor);
   bool do_atom_virial_tensor = atomic;
@@ -19,7 +19,7 @@ static void run_model(
     std::vector<ENERGYTYPE>& dener,
     std::vector<VALUETYPE>& dforce_,
     std::vector<VALUETYPE>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
@@ -39,9 +39,9 @@ static void run_model(
   }
 
   std::vector<Tensor> output_tensors;
-  check_status(session->Run(
-      input_tensors, {"o_energy", "o_force", "o_atom_energy", "o_atom_virial"},
-      {}, &output_tensors));
+  callables.run(input_tensors,
+                {"o_energy", "o_force", "o_atom_energy", "o_atom_virial"},
+                &output_tensors);
 
   Tensor output_e = output_tensors[0];
   Tensor output_f = output_tensors[1];
@@ -83,7 +83,7 @@ template void run_model<double, double>(
     std::vector<ENERGYTYPE>& dener,
     std::vector<double>& dforce_,
     std::vector<double>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
@@ -93,7 +93,7 @@ template void run_model<double, float>(
     std::vector<ENERGYTYPE>& dener,
     std::vector<float>& dforce_,
     std::vector<float>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
@@ -103,7 +103,7 @@ template void run_model<float, double>(
     std::vector<ENERGYTYPE>& dener,
     std::vector<double>& dforce_,
     std::vector<double>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
@@ -113,7 +113,7 @@ template void run_model<float, float>(
     std::vector<ENERGYTYPE>& dener,
     std::vector<float>& dforce_,
     std::vector<float>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
@@ -126,7 +126,7 @@ static void run_model(
     std::vector<VALUETYPE>& dvirial,
     std::vector<VALUETYPE>& datom_energy_,
     std::vector<VALUETYPE>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -152,9 +152,9 @@ static void run_model(
   }
   std::vector<Tensor> output_tensors;
 
-  check_status(session->Run(
-      input_tensors, {"o_energy", "o_force", "o_atom_energy", "o_atom_virial"},
-      {}, &output_tensors));
+  callables.run(input_tensors,
+                {"o_energy", "o_force", "o_atom_energy", "o_atom_virial"},
+                &output_tensors);
 
   Tensor output_e = output_tensors[0];
   Tensor output_f = output_tensors[1];
@@ -225,7 +225,7 @@ template void run_model<double, double>(
     std::vector<double>& dvirial,
     std::vector<double>& datom_energy_,
     std::vector<double>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -237,7 +237,7 @@ template void run_model<double, float>(
     std::vector<float>& dvirial,
     std::vector<float>& datom_energy_,
     std::vector<float>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -249,7 +249,7 @@ template void run_model<float, double>(
     std::vector<double>& dvirial,
     std::vector<double>& datom_energy_,
     std::vector<double>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -261,7 +261,7 @@ template void run_model<float, float>(
     std::vector<float>& dvirial,
     std::vector<float>& datom_energy_,
     std::vector<float>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -276,7 +276,7 @@ static void run_model(
     ENERGYTYPE& dener,
     std::vector<VALUETYPE>& dforce_,
     std::vector<VALUETYPE>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes = 1,
@@ -284,7 +284,7 @@ static void run_model(
   assert(nframes == 1);
   std::vector<ENERGYTYPE> dener_(1);
   // call multi-frame version
-  run_model<MODELTYPE, VALUETYPE>(dener_, dforce_, dvirial, session,
+  run_model<MODELTYPE, VALUETYPE>(dener_, dforce_, dvirial, callables,
                                   input_tensors, atommap, nframes, nghost);
   dener = dener_[0];
 }
@@ -293,7 +293,7 @@ template void run_model<double, double>(
     ENERGYTYPE& dener,
     std::vector<double>& dforce_,
     std::vector<double>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
@@ -303,7 +303,7 @@ template void run_model<double, float>(
     ENERGYTYPE& dener,
     std::vector<float>& dforce_,
     std::vector<float>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
@@ -313,7 +313,7 @@ template void run_model<float, double>(
     ENERGYTYPE& dener,
     std::vector<double>& dforce_,
     std::vector<double>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
@@ -323,7 +323,7 @@ template void run_model<float, float>(
     ENERGYTYPE& dener,
     std::vector<float>& dforce_,
     std::vector<float>& dvirial,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const AtomMap& atommap,
     const int nframes,
@@ -336,7 +336,7 @@ static void run_model(
     std::vector<VALUETYPE>& dvirial,
     std::vector<VALUETYPE>& datom_energy_,
     std::vector<VALUETYPE>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes = 1,
@@ -345,7 +345,7 @@ static void run_model(
   std::vector<ENERGYTYPE> dener_(1);
   // call multi-frame version
   run_model<MODELTYPE, VALUETYPE>(dener_, dforce_, dvirial, datom_energy_,
-                                  datom_virial_, session, input_tensors,
+                                  datom_virial_, callables, input_tensors,
                                   atommap, nframes, nghost);
   dener = dener_[0];
 }
@@ -356,7 +356,7 @@ template void run_model<double, double>(
     std::vector<double>& dvirial,
     std::vector<double>& datom_energy_,
     std::vector<double>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -368,7 +368,7 @@ template void run_model<double, float>(
     std::vector<float>& dvirial,
     std::vector<float>& datom_energy_,
     std::vector<float>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -380,7 +380,7 @@ template void run_model<float, double>(
     std::vector<double>& dvirial,
     std::vector<double>& datom_energy_,
     std::vector<double>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -392,7 +392,7 @@ template void run_model<float, float>(
     std::vector<float>& dvirial,
     std::vector<float>& datom_energy_,
     std::vector<float>& datom_virial_,
-    Session* session,
+    SessionCallables& callables,
     const std::vector<std::pair<std::string, Tensor>>& input_tensors,
     const deepmd::AtomMap& atommap,
     const int& nframes,
@@ -431,13 +431,19 @@ void DeepSpinTF::init(const std::string& model,
   get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
   options.config.set_inter_op_parallelism_threads(num_inter_nthreads);
   options.config.set_intra_op_parallelism_threads(num_intra_nthreads);
-  deepmd::load_op_library();
 
   if (file_content.size() == 0) {
     check_status(ReadBinaryProto(Env::Default(), model, graph_def));
   } else {
     (*graph_def).ParseFromString(file_content);
   }
+  // the OP library is only needed by graphs using the customized OPs, while
+  // the plugins are always loaded
+  if (has_unregistered_ops(*graph_def)) {
+    deepmd::load_op_library(DPBackend::TensorFlow);
+  } else {
+    deepmd::load_plugin_library();
+  }
   int gpu_num = -1;
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
   DPGetDeviceCount(gpu_num);  // check current device environment
@@ -457,6 +463,7 @@ void DeepSpinTF::init(const std::string& model,
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
   check_status(NewSession(options, &session));
   check_status(session->Create(*graph_def));
+  callables.reset(session);
   try {
     model_version = get_scalar<STRINGTYPE>("model_attr/model_version");
   } catch (deepmd::tf_exception& e) {
@@ -615,10 +622,10 @@ void DeepSpinTF::compute(ENERGYVTYPE& dener,
         fparam, aparam, atommap, "", aparam_nall);
     if (atomic) {
       run_model<double>(dener, dforce_tmp, dvirial, datom_energy_,
-                        datom_virial_, session, input_tensors, atommap,
+                        datom_virial_, callables, input_tensors, atommap,
                         nframes);
     } else {
-      run_model<double>(dener, dforce_tmp, dvirial, session, input_tensors,
+      run_model<double>(dener, dforce_tmp, dvirial, callables, input_tensors,
                         atommap, nframes);
     }
   } else {
@@ -627,9 +634,9 @@ void DeepSpinTF::compute(ENERGYVTYPE& dener,
         fparam, aparam, atommap, "", aparam_nall);
     if (atomic) {
       run_model<float>(dener, dforce_tmp, dvirial, datom_energy_, datom_virial_,
-                       session, input_tensors, atommap, nframes);
+                       callables, input_tensors, atommap, nframes);
     } else {
-      run_model<float>(dener, dforce_tmp, dvirial, session, input_tensors,
+      run_model<float>(dener, dforce_tmp, dvirial, callables, input_tensors,
                        atommap, nframes);
     }
   }
@@ -773,10 +780,11 @@ void DeepSpinTF::compute(ENERGYVTYPE& dener,
     assert(nloc_real == ret);
     if (atomic) {
       run_model<double>(dener, dforce, dvirial, datom_energy, datom_virial,
-                        session, input_tensors, atommap, nframes, nghost_real);
+                        callables, input_tensors, atommap, nframes,
+                        nghost_real);
     } else {
-      run_model<double>(dener, dforce, dvirial, session, input_tensors, atommap,
-                        nframes, nghost_real);
+      run_model<double>(dener, dforce, dvirial, callables, input_tensors,
+                        atommap, nframes, nghost_real);
     }
   } else {
     int ret = session_input_tensors<float>(
@@ -785,10 +793,10 @@ void DeepSpinTF::compute(ENERGYVTYPE& dener,
     assert(nloc_real == ret);
     if (atomic) {
       run_model<float>(dener, dforce, dvirial, datom_energy, datom_virial,
-                       session, input_tensors, atommap, nframes, nghost_real);
+                       callables, input_tensors, atommap, nframes, nghost_real);
     } else {
-      run_model<float>(dener, dforce, dvirial, session, input_tensors, atommap,
-                       nframes, nghost_real);
+      run_model<float>(dener, dforce, dvirial, callables, input_tensors,
+                       atommap, nframes, nghost_real);
     }
   }
 
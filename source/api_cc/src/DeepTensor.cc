@@ -32,6 +32,7 @@ void DeepTensor::init(const std::string &model,
   }
   const DPBackend backend = get_backend(model);
   if (deepmd::DPBackend::TensorFlow == backend) {
+    reject_memmapped_model(model, "DeepTensor");
 #ifdef BUILD_TENSORFLOW
     dt = std::make_shared<deepmd::DeepTensorTF>(model, gpu_rank, name_scope_);
 #else
@@ -36,7 +36,7 @@ void DeepTensorTF::init(const std::string &model,
   get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
   options.config.set_inter_op_parallelism_threads(num_inter_nthreads);
   options.config.set_intra_op_parallelism_threads(num_intra_nthreads);
-  deepmd::load_op_library();
+  deepmd::load_op_library(DPBackend::TensorFlow);
   int gpu_num = -1;
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
   DPGetDeviceCount(gpu_num);  // check current device environment
@@ -57,6 +57,7 @@ void DeepTensorTF::init(const std::string &model,
   deepmd::check_status(NewSession(options, &session));
   deepmd::check_status(ReadBinaryProto(Env::Default(), model, graph_def));
   deepmd::check_status(session->Create(*graph_def));
+  callables.reset(session);
   try {
     model_version = get_scalar<STRINGTYPE>("model_attr/model_version");
   } catch (deepmd::tf_exception &e) {
@@ -98,7 +99,7 @@ void DeepTensorTF::get_vector(std::vector<VT> &vec,
 template <typename MODELTYPE, typename VALUETYPE>
 void DeepTensorTF::run_model(
     std::vector<VALUETYPE> &d_tensor_,
-    Session *session,
+    SessionCallables &callables,
     const std::vector<std::pair<std::string, Tensor>> &input_tensors,
     const AtomMap &atommap,
     const std::vector<int> &sel_fwd,
@@ -112,9 +113,8 @@ void DeepTensorTF::run_model(
   }
 
   std::vector<Tensor> output_tensors;
-  deepmd::check_status(
-      session->Run(input_tensors, {name_prefix(name_scope) + "o_" + model_type},
-                   {}, &output_tensors));
+  callables.run(input_tensors, {name_prefix(name_scope) + "o_" + model_type},
+                &output_tensors);
 
   Tensor output_t = output_tensors[0];
   // Yixiao: newer model may output rank 2 tensor [nframes x (natoms x noutdim)]
@@ -140,28 +140,28 @@ void DeepTensorTF::run_model(
 
 template void DeepTensorTF::run_model<double, double>(
     std::vector<double> &d_tensor_,
-    Session *session,
+    SessionCallables &callables,
     const std::vector<std::pair<std::string, Tensor>> &input_tensors,
     const AtomMap &atommap,
     const std::vector<int> &sel_fwd,
     const int nghost);
 template void DeepTensorTF::run_model<float, double>(
     std::vector<double> &d_tensor_,
-    Session *session,
+    SessionCallables &callables,
     const std::vector<std::pair<std::string, Tensor>> &input_tensors,
     const AtomMap &atommap,
     const std::vector<int> &sel_fwd,
     const int nghost);
 template void DeepTensorTF::run_model<double, float>(
     std::vector<float> &d_tensor_,
-    Session *session,
+    SessionCallables &callables,
     const std::vector<std::pair<std::string, Tensor>> &input_tensors,
     const AtomMap &atommap,
     const std::vector<int> &sel_fwd,
     const int nghost);
 template void DeepTensorTF::run_model<float, float>(
     std::vector<float> &d_tensor_,
-    Session *session,
+    SessionCallables &callables,
     const std::vector<std::pair<std::string, Tensor>> &input_tensors,
     const AtomMap &atommap,
     const std::vector<int> &sel_fwd,
@@ -174,7 +174,7 @@ void DeepTensorTF::run_model(
     std::vector<VALUETYPE> &dvirial_,
     std::vector<VALUETYPE> &datom_tensor_,
     std::vector<VALUETYPE> &datom_virial_,
-    tensorflow::Session *session,
+    SessionCallables &callables,
     const std::vector<std::pair<std::string, tensorflow::Tensor>>
         &input_tensors,
     const AtomMap &atommap,
@@ -192,14 +192,13 @@ void DeepTensorTF::run_model(
   }
 
   std::vector<Tensor> output_tensors;
-  deepmd::check_status(
-      session->Run(input_tensors,
-                   {name_prefix(name_scope) + "o_global_" + model_type,
-                    name_prefix(name_scope) + "o_force",
-                    name_prefix(name_scope) + "o_virial",
-                    name_prefix(name_scope) + "o_" + model_type,
-                    name_prefix(name_scope) + "o_atom_virial"},
-                   {}, &output_tensors));
+  callables.run(input_tensors,
+                {name_prefix(name_scope) + "o_global_" + model_type,
+                 name_prefix(name_scope) + "o_force",
+                 name_prefix(name_scope) + "o_virial",
+                 name_prefix(name_scope) + "o_" + model_type,
+                 name_prefix(name_scope) + "o_atom_virial"},
+                &output_tensors);
 
   Tensor output_gt = output_tensors[0];
   Tensor output_f = output_tensors[1];
@@ -287,7 +286,7 @@ template void DeepTensorTF::run_model<double, double>(
     std::vector<double> &dvirial_,
     std::vector<double> &datom_tensor_,
     std::vector<double> &datom_virial_,
-    tensorflow::Session *session,
+    SessionCallables &callables,
     const std::vector<std::pair<std::string, tensorflow::Tensor>>
         &input_tensors,
     const AtomMap &atommap,
@@ -299,7 +298,7 @@ template void DeepTensorTF::run_model<float, double>(
     std::vector<double> &dvirial_,
     std::vector<double> &datom_tensor_,
     std::vector<double> &datom_virial_,
-    tensorflow::Session *session,
+    SessionCallables &callables,
     const std::vector<std::pair<std::string, tensorflow::Tensor>>
         &input_tensors,
     const AtomMap &atommap,
@@ -312,7 +311,7 @@ template void DeepTensorTF::run_model<double, float>(
     std::vector<float> &dvirial_,
     std::vector<float> &datom_tensor_,
     std::vector<float> &datom_virial_,
-    tensorflow::Session *session,
+    SessionCallables &callables,
     const std::vector<std::pair<std::string, tensorflow::Tensor>>
         &input_tensors,
     const AtomMap &atommap,
@@ -325,7 +324,7 @@ template void DeepTensorTF::run_model<float, float>(
     std::vector<float> &dvirial_,
     std::vector<float> &datom_tensor_,
     std::vector<float> &datom_virial_,
-    tensorflow::Session *session,
+    SessionCallables &callables,
     const std::vector<std::pair<std::string, tensorflow::Tensor>>
         &input_tensors,
     const AtomMap &atommap,
@@ -538,14 +537,14 @@ void DeepTensorTF::compute_inner(std::vector<VALUETYPE> &dtensor_,
         std::vector<VALUETYPE>(), std::vector<VALUETYPE>(), atommap,
         name_scope);
     assert(ret == nloc);
-    run_model<double>(dtensor_, session, input_tensors, atommap, sel_fwd);
+    run_model<double>(dtensor_, callables, input_tensors, atommap, sel_fwd);
   } else {
     int ret = session_input_tensors<float>(
         input_tensors, dcoord_, ntypes, datype_, dbox, cell_size,
         std::vector<VALUETYPE>(), std::vector<VALUETYPE>(), atommap,
         name_scope);
     assert(ret == nloc);
-    run_model<float>(dtensor_, session, input_tensors, atommap, sel_fwd);
+    run_model<float>(dtensor_, callables, input_tensors, atommap, sel_fwd);
   }
 }
 
@@ -594,7 +593,7 @@ void DeepTensorTF::compute_inner(std::vector<VALUETYPE> &dtensor_,
         std::vector<VALUETYPE>(), std::vector<VALUETYPE>(), atommap, nghost, 0,
         name_scope);
     assert(nloc == ret);
-    run_model<double>(dtensor_, session, input_tensors, atommap, sel_fwd,
+    run_model<double>(dtensor_, callables, input_tensors, atommap, sel_fwd,
                       nghost);
   } else {
     int ret = session_input_tensors<float>(
@@ -602,7 +601,7 @@ void DeepTensorTF::compute_inner(std::vector<VALUETYPE> &dtensor_,
         std::vector<VALUETYPE>(), std::vector<VALUETYPE>(), atommap, nghost, 0,
         name_scope);
     assert(nloc == ret);
-    run_model<float>(dtensor_, session, input_tensors, atommap, sel_fwd,
+    run_model<float>(dtensor_, callables, input_tensors, atommap, sel_fwd,
                      nghost);
   }
 }
@@ -651,7 +650,8 @@ void DeepTensorTF::compute_inner(std::vector<VALUETYPE> &dglobal_tensor_,
         name_scope);
     assert(ret == nloc);
     run_model<double>(dglobal_tensor_, dforce_, dvirial_, datom_tensor_,
-                      datom_virial_, session, input_tensors, atommap, sel_fwd);
+                      datom_virial_, callables, input_tensors, atommap,
+                      sel_fwd);
   } else {
     int ret = session_input_tensors<float>(
         input_tensors, dcoord_, ntypes, datype_, dbox, cell_size,
@@ -659,7 +659,7 @@ void DeepTensorTF::compute_inner(std::vector<VALUETYPE> &dglobal_tensor_,
         name_scope);
     assert(ret == nloc);
     run_model<float>(dglobal_tensor_, dforce_, dvirial_, datom_tensor_,
-                     datom_virial_, session, input_tensors, atommap, sel_fwd);
+                     datom_virial_, callables, input_tensors, atommap, sel_fwd);
   }
 }
 
@@ -721,8 +721,8 @@ void DeepTensorTF::compute_inner(std::vector<VALUETYPE> &dglobal_tensor_,
         name_scope);
     assert(nloc == ret);
     run_model<double>(dglobal_tensor_, dforce_, dvirial_, datom_tensor_,
-                      datom_virial_, session, input_tensors, atommap, sel_fwd,
-                      nghost);
+                      datom_virial_, callables, input_tensors, atommap,
+                      sel_fwd, nghost);
   } else {
     int ret = session_input_tensors<float>(
         input_tensors, dcoord_, ntypes, datype_, dbox, nlist,
@@ -730,7 +730,7 @@ void DeepTensorTF::compute_inner(std::vector<VALUETYPE> &dglobal_tensor_,
         name_scope);
     assert(nloc == ret);
     run_model<float>(dglobal_tensor_, dforce_, dvirial_, datom_tensor_,
-                     datom_virial_, session, input_tensors, atommap, sel_fwd,
+                     datom_virial_, callables, input_tensors, atommap, sel_fwd,
                      nghost);
   }
 }
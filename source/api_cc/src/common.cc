@@ -3,8 +3,14 @@
 
 #include <fcntl.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <string>
 
@@ -25,9 +31,16 @@
 // not windows
 #include <dlfcn.h>
 #endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #ifdef BUILD_TENSORFLOW
 #include "commonTF.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "tensorflow/core/framework/op.h"
 #include "google/protobuf/text_format.h"
 
 using namespace tensorflow;
@@ -297,8 +310,8 @@ void deepmd::NeighborListData::shuffle_exclude_empty(
   ilist = new_ilist;
   jlist = new_jlist;
 }
-void deepmd::NeighborListData::padding() {
-  size_t max_length = 0;
+void deepmd::NeighborListData::padding(const size_t min_length) {
+  size_t max_length = min_length;
   for (const auto& row : jlist) {
     max_length = std::max(max_length, row.size());
   }
@@ -308,6 +321,46 @@ void deepmd::NeighborListData::padding() {
   }
 }
 
+int deepmd::ShapeBucketing::pad(const int n, const int padded) const {
+  // keep the bucket unless n goes over it or falls below it by two factors
+  if (n <= padded && n * factor * factor >= padded) {
+    return padded;
+  }
+  return static_cast<int>(std::ceil(n * factor));
+}
+
+void deepmd::ShapeBucketing::update(const int nloc_,
+                                    const int nall_,
+                                    const int nnei_,
+                                    const bool pad_atoms) {
+  const bool first = nall_padded == 0;
+  if (!first && nloc_ == nloc && nall_ == nall && nnei_ == nnei) {
+    return;
+  }
+  nloc = nloc_;
+  nall = nall_;
+  nnei = nnei_;
+  int new_nloc_padded = nloc, new_nall_padded = nall;
+  if (pad_atoms) {
+    new_nloc_padded = pad(nloc, nloc_padded);
+    // the ghost atoms are placed after the padded local atoms
+    new_nall_padded = pad(nall + new_nloc_padded - nloc, nall_padded);
+  }
+  const int new_nnei_padded = pad(nnei, nnei_padded);
+  if (!first) {
+    nshape_changes++;
+  }
+  if (new_nloc_padded != nloc_padded || new_nall_padded != nall_padded ||
+      new_nnei_padded != nnei_padded) {
+    if (!first) {
+      nbucket_changes++;
+    }
+    nloc_padded = new_nloc_padded;
+    nall_padded = new_nall_padded;
+    nnei_padded = new_nnei_padded;
+  }
+}
+
 void deepmd::NeighborListData::make_inlist(InputNlist& inlist) {
   int nloc = ilist.size();
   numneigh.resize(nloc);
@@ -329,6 +382,93 @@ void deepmd::check_status(const tensorflow::Status& status) {
     throw deepmd::tf_exception(status.ToString());
   }
 }
+
+bool deepmd::has_unregistered_ops(const tensorflow::GraphDef& graph_def) {
+  // the functions in the graph are called as OPs by their names
+  std::set<std::string> func_names;
+  for (const FunctionDef& func : graph_def.library().function()) {
+    func_names.insert(func.signature().name());
+  }
+  auto is_unregistered = [&func_names](const NodeDef& node) {
+    const tensorflow::OpRegistrationData* op_reg_data;
+    return !func_names.count(node.op()) &&
+           !OpRegistry::Global()->LookUp(node.op(), &op_reg_data).ok();
+  };
+  for (const NodeDef& node : graph_def.node()) {
+    if (is_unregistered(node)) {
+      return true;
+    }
+  }
+  for (const FunctionDef& func : graph_def.library().function()) {
+    for (const NodeDef& node : func.node_def()) {
+      if (is_unregistered(node)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+deepmd::SessionCallables::~SessionCallables() { release(); }
+
+void deepmd::SessionCallables::release() {
+  if (session) {
+    for (const auto& it : handles) {
+      if (it.second >= 0) {
+        // the status is ignored as nothing can be done with a failure here
+        session->ReleaseCallable(it.second).IgnoreError();
+      }
+    }
+  }
+  handles.clear();
+}
+
+void deepmd::SessionCallables::reset(tensorflow::Session* session_) {
+  release();
+  session = session_;
+}
+
+void deepmd::SessionCallables::run(
+    const std::vector<std::pair<std::string, Tensor>>& input_tensors,
+    const std::vector<std::string>& output_names,
+    std::vector<Tensor>* output_tensors) {
+  std::string signature;
+  for (const auto& input : input_tensors) {
+    signature += input.first + ",";
+  }
+  signature += ";";
+  for (const auto& name : output_names) {
+    signature += name + ",";
+  }
+  auto it = handles.find(signature);
+  if (it == handles.end()) {
+    CallableOptions options;
+    for (const auto& input : input_tensors) {
+      options.add_feed(input.first);
+    }
+    for (const auto& name : output_names) {
+      options.add_fetch(name);
+    }
+    Session::CallableHandle handle;
+    if (!session->MakeCallable(options, &handle).ok()) {
+      // fall back to Session::Run
+      handle = -1;
+    }
+    it = handles.emplace(signature, handle).first;
+  }
+  if (it->second < 0) {
+    check_status(session->Run(input_tensors, output_names, {}, output_tensors));
+    return;
+  }
+  std::vector<Tensor> feed_tensors;
+  feed_tensors.reserve(input_tensors.size());
+  for (const auto& input : input_tensors) {
+    feed_tensors.push_back(input.second);
+  }
+  RunMetadata run_metadata;
+  check_status(session->RunCallable(it->second, feed_tensors, output_tensors,
+                                    &run_metadata));
+}
 #endif
 
 void throw_env_not_set_warning(std::string env_name) {
@@ -339,8 +479,25 @@ void throw_env_not_set_warning(std::string env_name) {
             << std::endl;
 }
 
+// the thread budget of the model being initialized in this thread
+static thread_local int thread_budget = 0;
+
+deepmd::ScopedThreadBudget::ScopedThreadBudget(const int nthreads)
+    : last_nthreads(thread_budget) {
+  thread_budget = nthreads > 0 ? nthreads : 0;
+}
+
+deepmd::ScopedThreadBudget::~ScopedThreadBudget() {
+  thread_budget = last_nthreads;
+}
+
 void deepmd::get_env_nthreads(int& num_intra_nthreads,
                               int& num_inter_nthreads) {
+  if (thread_budget > 0) {
+    num_intra_nthreads = thread_budget;
+    num_inter_nthreads = 1;
+    return;
+  }
   num_intra_nthreads = 0;
   num_inter_nthreads = 0;
   const char* env_intra_nthreads =
@@ -381,7 +538,58 @@ void deepmd::get_env_nthreads(int& num_intra_nthreads,
   }
 }
 
+int deepmd::bind_node_cores(const int& node_rank, const int& node_nranks) {
+#if defined(__linux__)
+  if (node_nranks <= 0 || node_rank < 0 || node_rank >= node_nranks) {
+    return 0;
+  }
+  // the cores of the process before any binding, so that the blocks do not
+  // change if the function is called more than once
+  static const std::vector<int> process_cores = [] {
+    std::vector<int> cores;
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &mask) == 0) {
+      for (int ii = 0; ii < CPU_SETSIZE; ++ii) {
+        if (CPU_ISSET(ii, &mask)) {
+          cores.push_back(ii);
+        }
+      }
+    }
+    return cores;
+  }();
+  const int ncores = process_cores.size();
+  if (ncores < node_nranks) {
+    return 0;
+  }
+  const int start = static_cast<long>(node_rank) * ncores / node_nranks;
+  const int end = static_cast<long>(node_rank + 1) * ncores / node_nranks;
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int ii = start; ii < end; ++ii) {
+    CPU_SET(process_cores[ii], &mask);
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set_t), &mask) != 0) {
+    return 0;
+  }
+#ifdef _OPENMP
+#pragma omp parallel
+  { sched_setaffinity(0, sizeof(cpu_set_t), &mask); }
+#endif
+  return end - start;
+#else
+  return 0;
+#endif
+}
+
+// the libraries loaded by _load_library_path in this process
+static std::set<std::string> loaded_libraries;
+static std::mutex loaded_libraries_mutex;
+
 static inline void _load_library_path(std::string dso_path) {
+  if (loaded_libraries.count(dso_path)) {
+    return;
+  }
 #if defined(_WIN32)
   void* dso_handle = LoadLibrary(dso_path.c_str());
 #else
@@ -398,6 +606,7 @@ static inline void _load_library_path(std::string dso_path) {
 #endif
     );
   }
+  loaded_libraries.insert(dso_path);
 }
 
 static inline void _load_single_op_library(std::string library_name) {
@@ -409,14 +618,8 @@ static inline void _load_single_op_library(std::string library_name) {
   _load_library_path(dso_path);
 }
 
-void deepmd::load_op_library() {
-#ifdef BUILD_TENSORFLOW
-  _load_single_op_library("deepmd_op");
-#endif
-#ifdef BUILD_PYTORCH
-  _load_single_op_library("deepmd_op_pt");
-#endif
-  // load customized plugins
+// load customized plugins; loaded_libraries_mutex should be held
+static void _load_plugins() {
   const char* env_customized_plugins = std::getenv("DP_PLUGIN_PATH");
   if (env_customized_plugins) {
 #if !defined(_WIN32)
@@ -428,6 +631,9 @@ void deepmd::load_op_library() {
     std::string plugin_path(env_customized_plugins);
     std::vector<std::string> plugin_paths = split(plugin_path, pathvarsep);
     for (const auto& plugin : plugin_paths) {
+      if (loaded_libraries.count(plugin)) {
+        continue;
+      }
       std::cerr << "Loading customized plugin defined in DP_PLUGIN_PATH: "
                 << plugin << std::endl;
       _load_library_path(plugin);
@@ -435,6 +641,70 @@ void deepmd::load_op_library() {
   }
 }
 
+void deepmd::load_op_library(const DPBackend& backend) {
+  std::lock_guard<std::mutex> lock(loaded_libraries_mutex);
+#ifdef BUILD_TENSORFLOW
+  if (backend == DPBackend::TensorFlow || backend == DPBackend::Unknown) {
+    _load_single_op_library("deepmd_op");
+  }
+#endif
+#ifdef BUILD_PYTORCH
+  if (backend == DPBackend::PyTorch || backend == DPBackend::Unknown) {
+    _load_single_op_library("deepmd_op_pt");
+  }
+#endif
+  _load_plugins();
+}
+
+void deepmd::load_plugin_library() {
+  std::lock_guard<std::mutex> lock(loaded_libraries_mutex);
+  _load_plugins();
+}
+
+deepmd::InitTimer::InitTimer() {
+  start = std::chrono::steady_clock::now();
+  last = start;
+}
+
+void deepmd::InitTimer::record(const std::string& step) {
+  const std::chrono::steady_clock::time_point now =
+      std::chrono::steady_clock::now();
+  steps.emplace_back(step, std::chrono::duration<double>(now - last).count());
+  last = now;
+}
+
+bool deepmd::is_first_rank() {
+  const char* rank_vars[] = {"OMPI_COMM_WORLD_RANK", "PMI_RANK", "PMIX_RANK",
+                             "MV2_COMM_WORLD_RANK", "SLURM_PROCID"};
+  for (const char* var : rank_vars) {
+    const char* rank = std::getenv(var);
+    if (rank) {
+      return std::atoi(rank) == 0;
+    }
+  }
+  return true;
+}
+
+void deepmd::InitTimer::report(const std::string& model) const {
+  const char* env_timing = std::getenv("DP_INIT_TIMING");
+  if (env_timing == nullptr || std::string(env_timing) == "0" ||
+      !is_first_rank()) {
+    return;
+  }
+  std::ostringstream buffer;
+  buffer << std::fixed << std::setprecision(3);
+  buffer << "DeePMD-kit: initialize " << model << " in "
+         << std::chrono::duration<double>(last - start).count() << " s";
+  for (size_t ii = 0; ii < steps.size(); ++ii) {
+    buffer << (ii == 0 ? " (" : ", ") << steps[ii].first << ": "
+           << steps[ii].second << " s";
+  }
+  if (!steps.empty()) {
+    buffer << ")";
+  }
+  std::cout << buffer.str() << std::endl;
+}
+
 std::string deepmd::name_prefix(const std::string& scope) {
   std::string prefix = "";
   if (scope != "") {
@@ -444,6 +714,39 @@ std::string deepmd::name_prefix(const std::string& scope) {
 }
 
 #ifdef BUILD_TENSORFLOW
+/**
+ * @brief Copy atomic properties into a tensor, sorting the atoms by types.
+ * @details The forward map of the atom map is applied in the same pass, so no
+ * intermediate copy is made. Atoms beyond the atom map, i.e. ghost atoms, are
+ * copied as they are.
+ * @param[out] out The tensor of size nframes x (nall x stride).
+ * @param[in] in The atomic properties of size nframes x nall x stride.
+ * @param[in] atommap The atom map.
+ * @param[in] stride The number of values per atom.
+ * @param[in] nframes The number of frames.
+ * @param[in] nall The number of atoms.
+ */
+template <typename MODELTYPE, typename VALUETYPE>
+static void forward_to_tensor(typename TTypes<MODELTYPE>::Matrix out,
+                              const std::vector<VALUETYPE>& in,
+                              const deepmd::AtomMap& atommap,
+                              const int stride,
+                              const int nframes,
+                              const int nall) {
+  const std::vector<int>& idx_map = atommap.get_bkw_map();
+  const int nmap = idx_map.size();
+  for (int kk = 0; kk < nframes; ++kk) {
+    const VALUETYPE* in_frame =
+        in.data() + static_cast<size_t>(kk) * nall * stride;
+    for (int ii = 0; ii < nall; ++ii) {
+      const int from = ii < nmap ? idx_map[ii] : ii;
+      for (int dd = 0; dd < stride; ++dd) {
+        out(kk, ii * stride + dd) = in_frame[from * stride + dd];
+      }
+    }
+  }
+}
+
 template <typename MODELTYPE, typename VALUETYPE>
 int deepmd::session_input_tensors(
     std::vector<std::pair<std::string, Tensor>>& input_tensors,
@@ -520,21 +823,18 @@ int deepmd::session_input_tensors(
   auto fparam = fparam_tensor.matrix<MODELTYPE>();
   auto aparam = aparam_tensor.matrix<MODELTYPE>();
 
-  std::vector<VALUETYPE> dcoord(dcoord_);
-  atommap.forward<VALUETYPE>(dcoord.begin(), dcoord_.begin(), 3, nframes, nall);
-  std::vector<VALUETYPE> aparam_(aparam__);
+  // the atoms are sorted by types while being copied into the tensors
+  forward_to_tensor<MODELTYPE, VALUETYPE>(coord, dcoord_, atommap, 3, nframes,
+                                          nall);
   if ((aparam_nall ? nall : nloc) > 0) {
-    atommap.forward<VALUETYPE>(
-        aparam_.begin(), aparam__.begin(),
+    forward_to_tensor<MODELTYPE, VALUETYPE>(
+        aparam, aparam__, atommap,
         aparam__.size() / nframes / (aparam_nall ? nall : nloc), nframes,
         (aparam_nall ? nall : nloc));
   }
   // if == 0, aparam__.size should also be 0, so no need to forward
 
   for (int ii = 0; ii < nframes; ++ii) {
-    for (int jj = 0; jj < nall * 3; ++jj) {
-      coord(ii, jj) = dcoord[ii * nall * 3 + jj];
-    }
     if (b_pbc) {
       for (int jj = 0; jj < 9; ++jj) {
         box(ii, jj) = dbox[ii * 9 + jj];
@@ -550,9 +850,6 @@ int deepmd::session_input_tensors(
     for (int jj = 0; jj < fparam_.size() / nframes; ++jj) {
       fparam(ii, jj) = fparam_[ii * fparam_.size() / nframes + jj];
     }
-    for (int jj = 0; jj < aparam_.size() / nframes; ++jj) {
-      aparam(ii, jj) = aparam_[ii * aparam_.size() / nframes + jj];
-    }
   }
   if (b_pbc) {
     mesh(1 - 1) = 0;
@@ -580,7 +877,7 @@ int deepmd::session_input_tensors(
   if (fparam_.size() > 0) {
     input_tensors.push_back({prefix + "t_fparam", fparam_tensor});
   }
-  if (aparam_.size() > 0) {
+  if (aparam__.size() > 0) {
     input_tensors.push_back({prefix + "t_aparam", aparam_tensor});
   }
   return nloc;
@@ -660,21 +957,18 @@ int deepmd::session_input_tensors(
   auto fparam = fparam_tensor.matrix<MODELTYPE>();
   auto aparam = aparam_tensor.matrix<MODELTYPE>();
 
-  std::vector<VALUETYPE> dcoord(dcoord_);
-  atommap.forward<VALUETYPE>(dcoord.begin(), dcoord_.begin(), 3, nframes, nall);
-  std::vector<VALUETYPE> aparam_(aparam__);
+  // the atoms are sorted by types while being copied into the tensors
+  forward_to_tensor<MODELTYPE, VALUETYPE>(coord, dcoord_, atommap, 3, nframes,
+                                          nall);
   if ((aparam_nall ? nall : nloc) > 0) {
-    atommap.forward<VALUETYPE>(
-        aparam_.begin(), aparam__.begin(),
+    forward_to_tensor<MODELTYPE, VALUETYPE>(
+        aparam, aparam__, atommap,
         aparam__.size() / nframes / (aparam_nall ? nall : nloc), nframes,
         (aparam_nall ? nall : nloc));
   }
   // if == 0, aparam__.size should also be 0, so no need to forward
 
   for (int ii = 0; ii < nframes; ++ii) {
-    for (int jj = 0; jj < nall * 3; ++jj) {
-      coord(ii, jj) = dcoord[ii * nall * 3 + jj];
-    }
     for (int jj = 0; jj < 9; ++jj) {
       box(ii, jj) = dbox[ii * 9 + jj];
     }
@@ -684,9 +978,6 @@ int deepmd::session_input_tensors(
     for (int jj = 0; jj < fparam_.size() / nframes; ++jj) {
       fparam(ii, jj) = fparam_[ii * fparam_.size() / nframes + jj];
     }
-    for (int jj = 0; jj < aparam_.size() / nframes; ++jj) {
-      aparam(ii, jj) = aparam_[ii * aparam_.size() / nframes + jj];
-    }
   }
 
   for (int ii = 0; ii < 16; ++ii) {
@@ -722,7 +1013,7 @@ int deepmd::session_input_tensors(
   if (fparam_.size() > 0) {
     input_tensors.push_back({prefix + "t_fparam", fparam_tensor});
   }
-  if (aparam_.size() > 0) {
+  if (aparam__.size() > 0) {
     input_tensors.push_back({prefix + "t_aparam", aparam_tensor});
   }
   return nloc;
@@ -799,21 +1090,18 @@ int deepmd::session_input_tensors_mixed_type(
   auto fparam = fparam_tensor.matrix<MODELTYPE>();
   auto aparam = aparam_tensor.matrix<MODELTYPE>();
 
-  std::vector<VALUETYPE> dcoord(dcoord_);
-  atommap.forward<VALUETYPE>(dcoord.begin(), dcoord_.begin(), 3, nframes, nall);
-  std::vector<VALUETYPE> aparam_(aparam__);
+  // the atoms are sorted by types while being copied into the tensors
+  forward_to_tensor<MODELTYPE, VALUETYPE>(coord, dcoord_, atommap, 3, nframes,
+                                          nall);
   if ((aparam_nall ? nall : nloc) > 0) {
-    atommap.forward<VALUETYPE>(
-        aparam_.begin(), aparam__.begin(),
+    forward_to_tensor<MODELTYPE, VALUETYPE>(
+        aparam, aparam__, atommap,
         aparam__.size() / nframes / (aparam_nall ? nall : nloc), nframes,
         (aparam_nall ? nall : nloc));
   }
   // if == 0, aparam__.size should also be 0, so no need to forward
 
   for (int ii = 0; ii < nframes; ++ii) {
-    for (int jj = 0; jj < nall * 3; ++jj) {
-      coord(ii, jj) = dcoord[ii * nall * 3 + jj];
-    }
     if (b_pbc) {
       for (int jj = 0; jj < 9; ++jj) {
         box(ii, jj) = dbox[ii * 9 + jj];
@@ -829,9 +1117,6 @@ int deepmd::session_input_tensors_mixed_type(
     for (int jj = 0; jj < fparam_.size() / nframes; ++jj) {
       fparam(ii, jj) = fparam_[ii * fparam_.size() / nframes + jj];
     }
-    for (int jj = 0; jj < aparam_.size() / nframes; ++jj) {
-      aparam(ii, jj) = aparam_[ii * aparam_.size() / nframes + jj];
-    }
   }
   if (b_pbc) {
     mesh(1 - 1) = 0;
@@ -865,7 +1150,7 @@ int deepmd::session_input_tensors_mixed_type(
   if (fparam_.size() > 0) {
     input_tensors.push_back({prefix + "t_fparam", fparam_tensor});
   }
-  if (aparam_.size() > 0) {
+  if (aparam__.size() > 0) {
     input_tensors.push_back({prefix + "t_aparam", aparam_tensor});
   }
   return nloc;
@@ -1415,6 +1700,8 @@ deepmd::DPBackend deepmd::get_backend(const std::string& model) {
     return deepmd::DPBackend::PyTorch;
   } else if (model.length() >= 3 && model.substr(model.length() - 3) == ".pb") {
     return deepmd::DPBackend::TensorFlow;
+  } else if (is_memmapped_model(model)) {
+    return deepmd::DPBackend::TensorFlow;
   } else if (model.length() >= 11 &&
              model.substr(model.length() - 11) == ".savedmodel") {
     return deepmd::DPBackend::JAX;
@@ -1424,3 +1711,18 @@ deepmd::DPBackend deepmd::get_backend(const std::string& model) {
   }
   throw deepmd::deepmd_exception("Unsupported model file format");
 }
+
+bool deepmd::is_memmapped_model(const std::string& model) {
+  return model.length() >= 5 && model.substr(model.length() - 5) == ".pbmm";
+}
+
+void deepmd::reject_memmapped_model(const std::string& model,
+                                    const std::string& class_name) {
+  if (is_memmapped_model(model)) {
+    throw deepmd::deepmd_exception(
+        "memmapped TensorFlow models (.pbmm) are only supported by DeepPot, "
+        "but " +
+        model + " is loaded by " + class_name +
+        "; use the frozen model (.pb) instead");
+  }
+}
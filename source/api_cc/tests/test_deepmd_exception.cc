@@ -12,6 +12,7 @@
 
 #include "DataModifier.h"
 #include "DeepPot.h"
+#include "DeepSpin.h"
 #include "DeepTensor.h"
 #include "errors.h"
 TEST(TestDeepmdException, deepmdexception) {
@@ -46,3 +47,28 @@ TEST(TestDeepmdException, deepmdexception_nofile_dipolechargemodifier) {
   ASSERT_THROW(deepmd::DipoleChargeModifier("_no_such_file.pb"),
                deepmd::deepmd_exception);
 }
+
+// memmapped models are rejected before the file is read, so the message is
+// not a parse error of the file
+template <typename MODEL>
+static void expect_memmapped_rejected() {
+  try {
+    MODEL model("_no_such_file.pbmm");
+    FAIL() << "no exception is thrown";
+  } catch (deepmd::deepmd_exception &ex) {
+    EXPECT_NE(std::string(ex.what()).find("only supported by DeepPot"),
+              std::string::npos);
+  }
+}
+
+TEST(TestDeepmdException, deepmdexception_memmapped_deeptensor) {
+  expect_memmapped_rejected<deepmd::DeepTensor>();
+}
+
+TEST(TestDeepmdException, deepmdexception_memmapped_dipolechargemodifier) {
+  expect_memmapped_rejected<deepmd::DipoleChargeModifier>();
+}
+
+TEST(TestDeepmdException, deepmdexception_memmapped_deepspin) {
+  expect_memmapped_rejected<deepmd::DeepSpin>();
+}
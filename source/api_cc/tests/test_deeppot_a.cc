@@ -274,6 +274,47 @@ TYPED_TEST(TestInferDeepPotA, cpu_lmp_nlist) {
   }
 }
 
+TYPED_TEST(TestInferDeepPotA, cpu_lmp_nlist_no_virial) {
+  using VALUETYPE = TypeParam;
+  std::vector<VALUETYPE>& coord = this->coord;
+  std::vector<int>& atype = this->atype;
+  std::vector<VALUETYPE>& box = this->box;
+  std::vector<VALUETYPE>& expected_f = this->expected_f;
+  int& natoms = this->natoms;
+  double& expected_tot_e = this->expected_tot_e;
+  deepmd::DeepPot& dp = this->dp;
+  float rc = dp.cutoff();
+  int nloc = coord.size() / 3;
+  std::vector<VALUETYPE> coord_cpy;
+  std::vector<int> atype_cpy, mapping;
+  std::vector<std::vector<int> > nlist_data;
+  _build_nlist<VALUETYPE>(nlist_data, coord_cpy, atype_cpy, mapping, coord,
+                          atype, box, rc);
+  int nall = coord_cpy.size() / 3;
+  std::vector<int> ilist(nloc), numneigh(nloc);
+  std::vector<int*> firstneigh(nloc);
+  deepmd::InputNlist inlist(nloc, &ilist[0], &numneigh[0], &firstneigh[0]);
+  convert_nlist(inlist, nlist_data);
+
+  double ener;
+  std::vector<VALUETYPE> force_(nall * 3), force;
+  for (int ago : {0, 1}) {
+    ener = 0.;
+    std::fill(force_.begin(), force_.end(), 0.0);
+    dp.compute(ener, force_.data(), static_cast<VALUETYPE*>(nullptr),
+               static_cast<VALUETYPE*>(nullptr),
+               static_cast<VALUETYPE*>(nullptr), coord_cpy, atype_cpy, box,
+               nall - nloc, inlist, ago);
+    _fold_back<VALUETYPE>(force, force_, mapping, nloc, nall, 3);
+
+    EXPECT_EQ(force.size(), natoms * 3);
+    EXPECT_LT(fabs(ener - expected_tot_e), EPSILON);
+    for (int ii = 0; ii < natoms * 3; ++ii) {
+      EXPECT_LT(fabs(force[ii] - expected_f[ii]), EPSILON);
+    }
+  }
+}
+
 TYPED_TEST(TestInferDeepPotA, cpu_lmp_nlist_atomic) {
   using VALUETYPE = TypeParam;
   std::vector<VALUETYPE>& coord = this->coord;
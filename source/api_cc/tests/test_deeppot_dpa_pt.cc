@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <vector>
 
@@ -164,6 +165,63 @@ TYPED_TEST(TestInferDeepPotDpaPt, cpu_build_nlist_atomic) {
   }
 }
 
+TYPED_TEST(TestInferDeepPotDpaPt, cpu_lmp_nlist_warmup) {
+  using VALUETYPE = TypeParam;
+  std::vector<VALUETYPE>& coord = this->coord;
+  std::vector<int>& atype = this->atype;
+  std::vector<VALUETYPE>& box = this->box;
+  std::vector<VALUETYPE>& expected_f = this->expected_f;
+  int& natoms = this->natoms;
+  double& expected_tot_e = this->expected_tot_e;
+  std::vector<VALUETYPE>& expected_tot_v = this->expected_tot_v;
+  // the warm-up runs before the first evaluation, which has to exchange the
+  // ghost features through its own swaps
+  setenv("DP_PT_WARMUP_SHAPES", "6:60:40,12:120:40", 1);
+  deepmd::DeepPot dp;
+  dp.init("../../tests/infer/deeppot_dpa.pth");
+  unsetenv("DP_PT_WARMUP_SHAPES");
+  float rc = dp.cutoff();
+  int nloc = coord.size() / 3;
+  std::vector<VALUETYPE> coord_cpy;
+  std::vector<int> atype_cpy, mapping;
+  std::vector<std::vector<int> > nlist_data;
+  _build_nlist<VALUETYPE>(nlist_data, coord_cpy, atype_cpy, mapping, coord,
+                          atype, box, rc);
+  int nall = coord_cpy.size() / 3;
+  std::vector<int> ilist(nloc), numneigh(nloc);
+  std::vector<int*> firstneigh(nloc);
+  // all ghost atoms are received from the local atoms in a single swap with
+  // the rank itself
+  int nghost = nall - nloc;
+  std::vector<int> send_atoms(mapping.begin() + nloc, mapping.end());
+  int* sendlist[1] = {send_atoms.data()};
+  int sendproc[1] = {0}, recvproc[1] = {0};
+  int sendnum[1] = {nghost}, recvnum[1] = {nghost}, firstrecv[1] = {nloc};
+  deepmd::InputNlist inlist(nloc, &ilist[0], &numneigh[0], &firstneigh[0], 1,
+                            sendnum, recvnum, firstrecv, sendlist, sendproc,
+                            recvproc, nullptr);
+  convert_nlist(inlist, nlist_data);
+
+  for (int ago : {0, 1, 0}) {
+    double ener;
+    std::vector<VALUETYPE> force_, force, virial;
+    dp.compute(ener, force_, virial, coord_cpy, atype_cpy, box, nghost, inlist,
+               ago);
+    _fold_back<VALUETYPE>(force, force_, mapping, nloc, nall, 3);
+
+    EXPECT_EQ(force.size(), natoms * 3);
+    EXPECT_EQ(virial.size(), 9);
+
+    EXPECT_LT(fabs(ener - expected_tot_e), EPSILON);
+    for (int ii = 0; ii < natoms * 3; ++ii) {
+      EXPECT_LT(fabs(force[ii] - expected_f[ii]), EPSILON);
+    }
+    for (int ii = 0; ii < 3 * 3; ++ii) {
+      EXPECT_LT(fabs(virial[ii] - expected_tot_v[ii]), EPSILON);
+    }
+  }
+}
+
 template <class VALUETYPE>
 class TestInferDeepPotDpaPtNopbc : public ::testing::Test {
  protected:
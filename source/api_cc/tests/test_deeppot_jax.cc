@@ -271,6 +271,74 @@ TYPED_TEST(TestInferDeepPotAJAX, cpu_lmp_nlist) {
   }
 }
 
+TYPED_TEST(TestInferDeepPotAJAX, cpu_lmp_nlist_reuse_inputs) {
+  using VALUETYPE = TypeParam;
+  std::vector<VALUETYPE>& coord = this->coord;
+  std::vector<int>& atype = this->atype;
+  std::vector<VALUETYPE>& box = this->box;
+  int& natoms = this->natoms;
+  deepmd::DeepPot& dp = this->dp;
+  float rc = dp.cutoff();
+  int nloc = coord.size() / 3;
+  // neighbor lists of two sizes, so that the input tensors are reallocated
+  std::vector<float> rcs = {rc, rc * 2};
+  std::vector<std::vector<VALUETYPE> > coord_cpy(2);
+  std::vector<std::vector<int> > atype_cpy(2), mapping(2);
+  std::vector<std::vector<std::vector<int> > > nlist_data(2);
+  std::vector<std::vector<int> > ilist(2, std::vector<int>(nloc)),
+      numneigh(2, std::vector<int>(nloc));
+  std::vector<std::vector<int*> > firstneigh(2, std::vector<int*>(nloc));
+  std::vector<deepmd::InputNlist> inlist;
+  for (int kk = 0; kk < 2; ++kk) {
+    _build_nlist<VALUETYPE>(nlist_data[kk], coord_cpy[kk], atype_cpy[kk],
+                            mapping[kk], coord, atype, box, rcs[kk]);
+    inlist.emplace_back(nloc, &ilist[kk][0], &numneigh[kk][0],
+                        &firstneigh[kk][0]);
+    convert_nlist(inlist[kk], nlist_data[kk]);
+  }
+
+  // each step gives the neighbor list, ago, and the displacement of atom 0;
+  // the coordinates are rewritten into the reused tensors when ago > 0, and
+  // atom 0 is only moved with the neighbor list of 2 rc, which stays valid
+  struct Step {
+    int kk;
+    int ago;
+    VALUETYPE shift;
+  };
+  std::vector<Step> steps = {
+      {0, 0, 0.}, {1, 0, 0.}, {1, 1, 0.001}, {0, 0, 0.}, {0, 1, 0.}};
+  for (const Step& step : steps) {
+    std::vector<VALUETYPE> coord_step(coord);
+    std::vector<VALUETYPE> coord_cpy_step(coord_cpy[step.kk]);
+    coord_step[0] += step.shift;
+    for (int jj = 0; jj < coord_cpy_step.size() / 3; ++jj) {
+      if (mapping[step.kk][jj] == 0) {
+        coord_cpy_step[jj * 3] += step.shift;
+      }
+    }
+    int nall = coord_cpy_step.size() / 3;
+    // the reference from the overload without the neighbor list
+    double ener_ref;
+    std::vector<VALUETYPE> force_ref, virial_ref;
+    dp.compute(ener_ref, force_ref, virial_ref, coord_step, atype, box);
+
+    double ener;
+    std::vector<VALUETYPE> force_, force, virial;
+    dp.compute(ener, force_, virial, coord_cpy_step, atype_cpy[step.kk], box,
+               nall - nloc, inlist[step.kk], step.ago);
+    _fold_back<VALUETYPE>(force, force_, mapping[step.kk], nloc, nall, 3);
+    EXPECT_EQ(force.size(), natoms * 3);
+    EXPECT_EQ(virial.size(), 9);
+    EXPECT_LT(fabs(ener - ener_ref), EPSILON);
+    for (int ii = 0; ii < natoms * 3; ++ii) {
+      EXPECT_LT(fabs(force[ii] - force_ref[ii]), EPSILON);
+    }
+    for (int ii = 0; ii < 3 * 3; ++ii) {
+      EXPECT_LT(fabs(virial[ii] - virial_ref[ii]), EPSILON);
+    }
+  }
+}
+
 TYPED_TEST(TestInferDeepPotAJAX, cpu_lmp_nlist_atomic) {
   using VALUETYPE = TypeParam;
   std::vector<VALUETYPE>& coord = this->coord;
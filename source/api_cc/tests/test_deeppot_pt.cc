@@ -256,6 +256,53 @@ TYPED_TEST(TestInferDeepPotAPt, cpu_lmp_nlist) {
   }
 }
 
+TYPED_TEST(TestInferDeepPotAPt, cpu_lmp_nlist_reuse_buffers) {
+  using VALUETYPE = TypeParam;
+  std::vector<VALUETYPE>& coord = this->coord;
+  std::vector<int>& atype = this->atype;
+  std::vector<VALUETYPE>& box = this->box;
+  int& natoms = this->natoms;
+  deepmd::DeepPot& dp = this->dp;
+  float rc = dp.cutoff();
+  int nloc = coord.size() / 3;
+  std::vector<VALUETYPE> coord_cpy;
+  std::vector<int> atype_cpy, mapping;
+  std::vector<std::vector<int> > nlist_data;
+  _build_nlist<VALUETYPE>(nlist_data, coord_cpy, atype_cpy, mapping, coord,
+                          atype, box, rc);
+  int nall = coord_cpy.size() / 3;
+  std::vector<int> ilist(nloc), numneigh(nloc);
+  std::vector<int*> firstneigh(nloc);
+  deepmd::InputNlist inlist(nloc, &ilist[0], &numneigh[0], &firstneigh[0]);
+  convert_nlist(inlist, nlist_data);
+
+  // the reference from the overload without the neighbor list
+  double ener_ref;
+  std::vector<VALUETYPE> force_ref, virial_ref;
+  dp.compute(ener_ref, force_ref, virial_ref, coord, atype, box);
+
+  // the input buffers shrink and grow between the calls, and the neighbor
+  // list flattened at ago == 0 is reused by the later calls
+  double ener, ener_small;
+  std::vector<VALUETYPE> force_, force, virial, force_small, virial_small;
+  for (int ago : {0, 1, 1}) {
+    dp.compute(ener, force_, virial, coord_cpy, atype_cpy, box, nall - nloc,
+               inlist, ago);
+    _fold_back<VALUETYPE>(force, force_, mapping, nloc, nall, 3);
+    EXPECT_EQ(force.size(), natoms * 3);
+    EXPECT_EQ(virial.size(), 9);
+    EXPECT_LT(fabs(ener - ener_ref), EPSILON);
+    for (int ii = 0; ii < natoms * 3; ++ii) {
+      EXPECT_LT(fabs(force[ii] - force_ref[ii]), EPSILON);
+    }
+    for (int ii = 0; ii < 3 * 3; ++ii) {
+      EXPECT_LT(fabs(virial[ii] - virial_ref[ii]), EPSILON);
+    }
+    dp.compute(ener_small, force_small, virial_small, coord, atype, box);
+    EXPECT_LT(fabs(ener_small - ener_ref), EPSILON);
+  }
+}
+
 TYPED_TEST(TestInferDeepPotAPt, cpu_lmp_nlist_atomic) {
   using VALUETYPE = TypeParam;
   std::vector<VALUETYPE>& coord = this->coord;
@@ -339,6 +386,63 @@ TYPED_TEST(TestInferDeepPotAPt, cpu_lmp_nlist_atomic) {
   }
 }
 
+TYPED_TEST(TestInferDeepPotAPt, cpu_lmp_nlist_atomic_buffer) {
+  using VALUETYPE = TypeParam;
+  std::vector<VALUETYPE>& coord = this->coord;
+  std::vector<int>& atype = this->atype;
+  std::vector<VALUETYPE>& box = this->box;
+  std::vector<VALUETYPE>& expected_e = this->expected_e;
+  std::vector<VALUETYPE>& expected_f = this->expected_f;
+  std::vector<VALUETYPE>& expected_v = this->expected_v;
+  int& natoms = this->natoms;
+  double& expected_tot_e = this->expected_tot_e;
+  std::vector<VALUETYPE>& expected_tot_v = this->expected_tot_v;
+  deepmd::DeepPot& dp = this->dp;
+  float rc = dp.cutoff();
+  int nloc = coord.size() / 3;
+  std::vector<VALUETYPE> coord_cpy;
+  std::vector<int> atype_cpy, mapping;
+  std::vector<std::vector<int> > nlist_data;
+  _build_nlist<VALUETYPE>(nlist_data, coord_cpy, atype_cpy, mapping, coord,
+                          atype, box, rc);
+  int nall = coord_cpy.size() / 3;
+  std::vector<int> ilist(nloc), numneigh(nloc);
+  std::vector<int*> firstneigh(nloc);
+  deepmd::InputNlist inlist(nloc, &ilist[0], &numneigh[0], &firstneigh[0]);
+  convert_nlist(inlist, nlist_data);
+  double ener;
+  std::vector<VALUETYPE> force_(nall * 3), atom_ener_(nall), atom_vir_(nall * 9),
+      virial(9);
+  std::vector<VALUETYPE> force, atom_ener, atom_vir;
+  for (int ago : {0, 1}) {
+    ener = 0.;
+    std::fill(force_.begin(), force_.end(), 0.0);
+    std::fill(virial.begin(), virial.end(), 0.0);
+    std::fill(atom_ener_.begin(), atom_ener_.end(), 0.0);
+    std::fill(atom_vir_.begin(), atom_vir_.end(), 0.0);
+    dp.compute(ener, force_.data(), virial.data(), atom_ener_.data(),
+               atom_vir_.data(), coord_cpy, atype_cpy, box, nall - nloc, inlist,
+               ago);
+    _fold_back<VALUETYPE>(force, force_, mapping, nloc, nall, 3);
+    _fold_back<VALUETYPE>(atom_ener, atom_ener_, mapping, nloc, nall, 1);
+    _fold_back<VALUETYPE>(atom_vir, atom_vir_, mapping, nloc, nall, 9);
+
+    EXPECT_LT(fabs(ener - expected_tot_e), EPSILON);
+    for (int ii = 0; ii < natoms * 3; ++ii) {
+      EXPECT_LT(fabs(force[ii] - expected_f[ii]), EPSILON);
+    }
+    for (int ii = 0; ii < 3 * 3; ++ii) {
+      EXPECT_LT(fabs(virial[ii] - expected_tot_v[ii]), EPSILON);
+    }
+    for (int ii = 0; ii < natoms; ++ii) {
+      EXPECT_LT(fabs(atom_ener[ii] - expected_e[ii]), EPSILON);
+    }
+    for (int ii = 0; ii < natoms * 9; ++ii) {
+      EXPECT_LT(fabs(atom_vir[ii] - expected_v[ii]), EPSILON);
+    }
+  }
+}
+
 TYPED_TEST(TestInferDeepPotAPt, cpu_lmp_nlist_2rc) {
   using VALUETYPE = TypeParam;
   std::vector<VALUETYPE>& coord = this->coord;
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+
+class TestEnvNthreads : public ::testing::Test {
+ protected:
+  std::vector<std::string> env_names = {
+      "DP_INTRA_OP_PARALLELISM_THREADS", "DP_INTER_OP_PARALLELISM_THREADS",
+      "TF_INTRA_OP_PARALLELISM_THREADS", "TF_INTER_OP_PARALLELISM_THREADS"};
+  std::vector<std::string> env_values;
+  std::vector<bool> env_set;
+
+  void SetUp() override {
+    for (const std::string& name : env_names) {
+      const char* value = std::getenv(name.c_str());
+      env_set.push_back(value != nullptr);
+      env_values.push_back(value ? value : "");
+      unsetenv(name.c_str());
+    }
+  }
+
+  void TearDown() override {
+    for (size_t ii = 0; ii < env_names.size(); ++ii) {
+      if (env_set[ii]) {
+        setenv(env_names[ii].c_str(), env_values[ii].c_str(), 1);
+      } else {
+        unsetenv(env_names[ii].c_str());
+      }
+    }
+  }
+};
+
+TEST_F(TestEnvNthreads, not_set) {
+  int num_intra_nthreads = -1, num_inter_nthreads = -1;
+  deepmd::get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
+  EXPECT_EQ(num_intra_nthreads, 0);
+  EXPECT_EQ(num_inter_nthreads, 0);
+}
+
+TEST_F(TestEnvNthreads, dp_env) {
+  setenv("DP_INTRA_OP_PARALLELISM_THREADS", "4", 1);
+  setenv("DP_INTER_OP_PARALLELISM_THREADS", "2", 1);
+  // the DP variables take precedence over the TF ones
+  setenv("TF_INTRA_OP_PARALLELISM_THREADS", "8", 1);
+  setenv("TF_INTER_OP_PARALLELISM_THREADS", "8", 1);
+  int num_intra_nthreads, num_inter_nthreads;
+  deepmd::get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
+  EXPECT_EQ(num_intra_nthreads, 4);
+  EXPECT_EQ(num_inter_nthreads, 2);
+}
+
+TEST_F(TestEnvNthreads, tf_env) {
+  setenv("TF_INTRA_OP_PARALLELISM_THREADS", "3", 1);
+  setenv("TF_INTER_OP_PARALLELISM_THREADS", "1", 1);
+  int num_intra_nthreads, num_inter_nthreads;
+  deepmd::get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
+  EXPECT_EQ(num_intra_nthreads, 3);
+  EXPECT_EQ(num_inter_nthreads, 1);
+}
+
+TEST_F(TestEnvNthreads, invalid_env) {
+  // empty and negative values fall back to the TF variables
+  setenv("DP_INTRA_OP_PARALLELISM_THREADS", "", 1);
+  setenv("DP_INTER_OP_PARALLELISM_THREADS", "-1", 1);
+  setenv("TF_INTER_OP_PARALLELISM_THREADS", "5", 1);
+  int num_intra_nthreads, num_inter_nthreads;
+  deepmd::get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
+  EXPECT_EQ(num_intra_nthreads, 0);
+  EXPECT_EQ(num_inter_nthreads, 5);
+}
+
+TEST_F(TestEnvNthreads, thread_budget) {
+  setenv("DP_INTRA_OP_PARALLELISM_THREADS", "4", 1);
+  setenv("DP_INTER_OP_PARALLELISM_THREADS", "2", 1);
+  int num_intra_nthreads, num_inter_nthreads;
+  {
+    deepmd::ScopedThreadBudget budget(6);
+    deepmd::get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
+    EXPECT_EQ(num_intra_nthreads, 6);
+    EXPECT_EQ(num_inter_nthreads, 1);
+    {
+      deepmd::ScopedThreadBudget inner_budget(3);
+      deepmd::get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
+      EXPECT_EQ(num_intra_nthreads, 3);
+      EXPECT_EQ(num_inter_nthreads, 1);
+    }
+    // the outer budget is restored
+    deepmd::get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
+    EXPECT_EQ(num_intra_nthreads, 6);
+    EXPECT_EQ(num_inter_nthreads, 1);
+    {
+      // a non-positive budget reads the environment variables
+      deepmd::ScopedThreadBudget no_budget(0);
+      deepmd::get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
+      EXPECT_EQ(num_intra_nthreads, 4);
+      EXPECT_EQ(num_inter_nthreads, 2);
+    }
+    // the budget only applies to the current thread
+    std::thread other([&] {
+      deepmd::get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
+    });
+    other.join();
+    EXPECT_EQ(num_intra_nthreads, 4);
+    EXPECT_EQ(num_inter_nthreads, 2);
+  }
+  // the environment variables are used again after the scope
+  deepmd::get_env_nthreads(num_intra_nthreads, num_inter_nthreads);
+  EXPECT_EQ(num_intra_nthreads, 4);
+  EXPECT_EQ(num_inter_nthreads, 2);
+}
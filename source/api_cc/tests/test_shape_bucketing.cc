@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+#include <gtest/gtest.h>
+
+#include "common.h"
+
+TEST(TestShapeBucketing, first_update) {
+  deepmd::ShapeBucketing bucketing(1.05);
+  bucketing.update(100, 400, 50);
+  EXPECT_EQ(bucketing.nloc, 100);
+  EXPECT_EQ(bucketing.nall, 400);
+  EXPECT_EQ(bucketing.nnei, 50);
+  EXPECT_EQ(bucketing.nloc_padded, 105);
+  EXPECT_EQ(bucketing.nall_padded, 426);
+  EXPECT_EQ(bucketing.nnei_padded, 53);
+  EXPECT_EQ(bucketing.num_shape_changes(), 0);
+  EXPECT_EQ(bucketing.num_bucket_changes(), 0);
+}
+
+TEST(TestShapeBucketing, padded_index) {
+  deepmd::ShapeBucketing bucketing(1.05);
+  bucketing.update(100, 400, 50);
+  EXPECT_EQ(bucketing.padded_index(0), 0);
+  EXPECT_EQ(bucketing.padded_index(99), 99);
+  // ghost atoms are placed after the padded local atoms
+  EXPECT_EQ(bucketing.padded_index(100), 105);
+  EXPECT_EQ(bucketing.padded_index(399), 404);
+  EXPECT_LT(bucketing.padded_index(399), bucketing.nall_padded);
+}
+
+TEST(TestShapeBucketing, keep_bucket) {
+  deepmd::ShapeBucketing bucketing(1.05);
+  bucketing.update(100, 400, 50);
+  bucketing.update(102, 405, 52);
+  bucketing.update(98, 398, 49);
+  bucketing.update(98, 398, 49);
+  EXPECT_EQ(bucketing.nloc_padded, 105);
+  EXPECT_EQ(bucketing.nall_padded, 426);
+  EXPECT_EQ(bucketing.nnei_padded, 53);
+  EXPECT_EQ(bucketing.num_shape_changes(), 2);
+  EXPECT_EQ(bucketing.num_bucket_changes(), 0);
+  EXPECT_EQ(bucketing.num_avoided(), 2);
+}
+
+TEST(TestShapeBucketing, change_bucket) {
+  deepmd::ShapeBucketing bucketing(1.05);
+  bucketing.update(100, 400, 50);
+  // over the bucket
+  bucketing.update(110, 420, 50);
+  EXPECT_EQ(bucketing.nloc_padded, 116);
+  EXPECT_GE(bucketing.nall_padded, 426);
+  // far below the bucket
+  bucketing.update(50, 200, 50);
+  EXPECT_EQ(bucketing.nloc_padded, 53);
+  EXPECT_EQ(bucketing.num_shape_changes(), 2);
+  EXPECT_EQ(bucketing.num_bucket_changes(), 2);
+}
+
+TEST(TestShapeBucketing, no_pad_atoms) {
+  deepmd::ShapeBucketing bucketing(1.05);
+  bucketing.update(100, 400, 50, false);
+  EXPECT_EQ(bucketing.nloc_padded, 100);
+  EXPECT_EQ(bucketing.nall_padded, 400);
+  EXPECT_EQ(bucketing.nnei_padded, 53);
+  EXPECT_EQ(bucketing.padded_index(100), 100);
+}
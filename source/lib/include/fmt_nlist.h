@@ -74,3 +74,28 @@ int format_nlist_i_cpu(std::vector<int>& fmt_nei_idx_a,
                        const std::vector<int>& nei_idx_a,
                        const float& rcut,
                        const std::vector<int>& sec_a);
+
+// same as format_nlist_i_cpu, but all neighbors in nei_idx_a are sorted in
+// place. if nei_idx_a was sorted by the last call, set b_sorted to true to
+// repair the order by insertion sort, which is cheap if the atoms moved
+// slightly
+template <typename FPTYPE>
+int reformat_nlist_i_cpu(std::vector<int>& fmt_nei_idx_a,
+                         std::vector<int>& nei_idx_a,
+                         const std::vector<FPTYPE>& posi,
+                         const std::vector<int>& type,
+                         const int& i_idx,
+                         const float& rcut,
+                         const std::vector<int>& sec_a,
+                         const bool& b_sorted);
+
+// return:	true	if fmt_nei_idx_a is exactly what format_nlist_i_cpu would
+//		produce from nei_idx_a at the current positions
+template <typename FPTYPE>
+bool check_fmt_nlist_i_cpu(const std::vector<int>& fmt_nei_idx_a,
+                           const std::vector<FPTYPE>& posi,
+                           const std::vector<int>& type,
+                           const int& i_idx,
+                           const std::vector<int>& nei_idx_a,
+                           const float& rcut,
+                           const std::vector<int>& sec_a);
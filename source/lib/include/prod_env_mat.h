@@ -7,6 +7,52 @@
 
 namespace deepmd {
 
+/**
+ * @brief The neighbor lists kept by prod_env_mat_a_cpu between two rebuilds
+ * of the input neighbor list.
+ */
+struct EnvMatNlistCache {
+  // keep the neighbors sorted by distance and repair the order by insertion
+  // sort between rebuilds, instead of checking the formatted neighbor lists
+  bool repair = false;
+  int nloc = 0;
+  int nall = 0;
+  // neighbors of each local atom gathered from the input neighbor list
+  std::vector<std::vector<int> > nlist_a;
+  // formatted neighbors of each local atom in the last evaluation
+  std::vector<std::vector<int> > fmt_nlist_a;
+};
+
+template <typename FPTYPE>
+void prod_env_mat_a_cpu(FPTYPE *em,
+                        FPTYPE *em_deriv,
+                        FPTYPE *rij,
+                        int *nlist,
+                        const FPTYPE *coord,
+                        const int *type,
+                        const InputNlist &inlist,
+                        const int max_nbor_size,
+                        const FPTYPE *avg,
+                        const FPTYPE *std,
+                        const int nloc,
+                        const int nall,
+                        const float rcut,
+                        const float rcut_smth,
+                        const std::vector<int> sec,
+                        const int *f_type = NULL);
+
+/**
+ * @brief Same as the above, but keep the neighbor lists in a cache.
+ * @details If reuse_nlist is true, the input neighbor list is assumed to be
+ * unchanged since the last call with the same cache, so it is not gathered
+ * again. The formatted neighbor list of an atom is reused if its neighbors
+ * within the cutoff and their order are unchanged, and is formatted again
+ * otherwise, so the results are the same as those without the cache.
+ * If cache.repair is true, the neighbors are instead kept sorted and
+ * repaired by insertion sort.
+ * @param[in,out] cache The neighbor lists kept between calls.
+ * @param[in] reuse_nlist Whether to reuse the neighbor lists in the cache.
+ */
 template <typename FPTYPE>
 void prod_env_mat_a_cpu(FPTYPE *em,
                         FPTYPE *em_deriv,
@@ -23,6 +69,8 @@ void prod_env_mat_a_cpu(FPTYPE *em,
                         const float rcut,
                         const float rcut_smth,
                         const std::vector<int> sec,
+                        EnvMatNlistCache &cache,
+                        const bool reuse_nlist,
                         const int *f_type = NULL);
 
 template <typename FPTYPE>
@@ -142,6 +142,130 @@ int format_nlist_i_cpu(std::vector<int> &fmt_nei_idx_a,
   return overflowed;
 }
 
+template <typename FPTYPE>
+int reformat_nlist_i_cpu(std::vector<int> &fmt_nei_idx_a,
+                         std::vector<int> &nei_idx_a,
+                         const std::vector<FPTYPE> &posi,
+                         const std::vector<int> &type,
+                         const int &i_idx,
+                         const float &rcut,
+                         const std::vector<int> &sec_a,
+                         const bool &b_sorted) {
+  fmt_nei_idx_a.resize(sec_a.back());
+  fill(fmt_nei_idx_a.begin(), fmt_nei_idx_a.end(), -1);
+
+  // keep all neighbors, including those out of the cutoff, in the sorted
+  // list, so that the neighbors entering the cutoff are in place
+  std::vector<NeighborInfo<float> > sel_nei(nei_idx_a.size());
+  for (unsigned kk = 0; kk < nei_idx_a.size(); ++kk) {
+    float diff[3];
+    const int &j_idx = nei_idx_a[kk];
+    for (int dd = 0; dd < 3; ++dd) {
+      diff[dd] = (float)posi[j_idx * 3 + dd] - (float)posi[i_idx * 3 + dd];
+    }
+    float rr2 = deepmd::dot3(diff, diff);
+    sel_nei[kk] = NeighborInfo<float>(type[j_idx], rr2, j_idx);
+  }
+  if (b_sorted) {
+    // insertion sort, linear if the order is almost unchanged
+    for (unsigned kk = 1; kk < sel_nei.size(); ++kk) {
+      NeighborInfo<float> curr = sel_nei[kk];
+      int ll = kk;
+      for (; ll > 0 && curr < sel_nei[ll - 1]; --ll) {
+        sel_nei[ll] = sel_nei[ll - 1];
+      }
+      sel_nei[ll] = curr;
+    }
+  } else {
+    sort(sel_nei.begin(), sel_nei.end());
+  }
+
+  float rcut2 = rcut * rcut;
+  std::vector<int> nei_iter = sec_a;
+  int overflowed = -1;
+  for (unsigned kk = 0; kk < sel_nei.size(); ++kk) {
+    nei_idx_a[kk] = sel_nei[kk].index;
+    const int &nei_type = sel_nei[kk].type;
+    if (nei_type < 0 || sel_nei[kk].dist > rcut2) {
+      continue;
+    }
+    if (nei_iter[nei_type] < sec_a[nei_type + 1]) {
+      fmt_nei_idx_a[nei_iter[nei_type]++] = sel_nei[kk].index;
+    } else {
+      overflowed = nei_type;
+    }
+  }
+  return overflowed;
+}
+
+template <typename FPTYPE>
+bool check_fmt_nlist_i_cpu(const std::vector<int> &fmt_nei_idx_a,
+                           const std::vector<FPTYPE> &posi,
+                           const std::vector<int> &type,
+                           const int &i_idx,
+                           const std::vector<int> &nei_idx_a,
+                           const float &rcut,
+                           const std::vector<int> &sec_a) {
+  if (fmt_nei_idx_a.size() != sec_a.back()) {
+    return false;
+  }
+  const int ntypes = sec_a.size() - 1;
+  float rcut2 = rcut * rcut;
+  // count the neighbors within the cutoff of each type
+  std::vector<int> nei_count(ntypes, 0);
+  for (unsigned kk = 0; kk < nei_idx_a.size(); ++kk) {
+    float diff[3];
+    const int &j_idx = nei_idx_a[kk];
+    if (type[j_idx] < 0) {
+      continue;
+    }
+    for (int dd = 0; dd < 3; ++dd) {
+      diff[dd] = (float)posi[j_idx * 3 + dd] - (float)posi[i_idx * 3 + dd];
+    }
+    float rr2 = deepmd::dot3(diff, diff);
+    if (rr2 <= rcut2) {
+      if (type[j_idx] >= ntypes) {
+        return false;
+      }
+      nei_count[type[j_idx]]++;
+    }
+  }
+  // the formatted neighbors of each type should be exactly those within the
+  // cutoff, in the order sorted by format_nlist_i_cpu
+  for (int tt = 0; tt < ntypes; ++tt) {
+    if (nei_count[tt] > sec_a[tt + 1] - sec_a[tt]) {
+      // overflowed, the sorting decides which neighbors are kept
+      return false;
+    }
+    NeighborInfo<float> prev;
+    for (int kk = sec_a[tt]; kk < sec_a[tt] + nei_count[tt]; ++kk) {
+      float diff[3];
+      const int &j_idx = fmt_nei_idx_a[kk];
+      if (j_idx < 0 || type[j_idx] != tt) {
+        return false;
+      }
+      for (int dd = 0; dd < 3; ++dd) {
+        diff[dd] = (float)posi[j_idx * 3 + dd] - (float)posi[i_idx * 3 + dd];
+      }
+      float rr2 = deepmd::dot3(diff, diff);
+      if (rr2 > rcut2) {
+        return false;
+      }
+      NeighborInfo<float> curr(tt, rr2, j_idx);
+      if (kk > sec_a[tt] && !(prev < curr)) {
+        return false;
+      }
+      prev = curr;
+    }
+    for (int kk = sec_a[tt] + nei_count[tt]; kk < sec_a[tt + 1]; ++kk) {
+      if (fmt_nei_idx_a[kk] != -1) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 template <typename FPTYPE>
 void deepmd::format_nlist_cpu(int *nlist,
                               const InputNlist &in_nlist,
@@ -192,6 +316,42 @@ template int format_nlist_i_cpu<float>(std::vector<int> &fmt_nei_idx_a,
                                        const float &rcut,
                                        const std::vector<int> &sec_a);
 
+template int reformat_nlist_i_cpu<double>(std::vector<int> &fmt_nei_idx_a,
+                                          std::vector<int> &nei_idx_a,
+                                          const std::vector<double> &posi,
+                                          const std::vector<int> &type,
+                                          const int &i_idx,
+                                          const float &rcut,
+                                          const std::vector<int> &sec_a,
+                                          const bool &b_sorted);
+
+template int reformat_nlist_i_cpu<float>(std::vector<int> &fmt_nei_idx_a,
+                                         std::vector<int> &nei_idx_a,
+                                         const std::vector<float> &posi,
+                                         const std::vector<int> &type,
+                                         const int &i_idx,
+                                         const float &rcut,
+                                         const std::vector<int> &sec_a,
+                                         const bool &b_sorted);
+
+template bool check_fmt_nlist_i_cpu<double>(
+    const std::vector<int> &fmt_nei_idx_a,
+    const std::vector<double> &posi,
+    const std::vector<int> &type,
+    const int &i_idx,
+    const std::vector<int> &nei_idx_a,
+    const float &rcut,
+    const std::vector<int> &sec_a);
+
+template bool check_fmt_nlist_i_cpu<float>(
+    const std::vector<int> &fmt_nei_idx_a,
+    const std::vector<float> &posi,
+    const std::vector<int> &type,
+    const int &i_idx,
+    const std::vector<int> &nei_idx_a,
+    const float &rcut,
+    const std::vector<int> &sec_a);
+
 template void deepmd::format_nlist_cpu<double>(
     int *nlist,
     const deepmd::InputNlist &in_nlist,
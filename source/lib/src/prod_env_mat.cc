@@ -28,6 +28,31 @@ void deepmd::prod_env_mat_a_cpu(FPTYPE *em,
                                 const float rcut_smth,
                                 const std::vector<int> sec,
                                 const int *f_type) {
+  EnvMatNlistCache cache;
+  prod_env_mat_a_cpu(em, em_deriv, rij, nlist, coord, type, inlist,
+                     max_nbor_size, avg, std, nloc, nall, rcut, rcut_smth, sec,
+                     cache, false, f_type);
+}
+
+template <typename FPTYPE>
+void deepmd::prod_env_mat_a_cpu(FPTYPE *em,
+                                FPTYPE *em_deriv,
+                                FPTYPE *rij,
+                                int *nlist,
+                                const FPTYPE *coord,
+                                const int *type,
+                                const InputNlist &inlist,
+                                const int max_nbor_size,
+                                const FPTYPE *avg,
+                                const FPTYPE *std,
+                                const int nloc,
+                                const int nall,
+                                const float rcut,
+                                const float rcut_smth,
+                                const std::vector<int> sec,
+                                EnvMatNlistCache &cache,
+                                const bool reuse_nlist,
+                                const int *f_type) {
   if (f_type == NULL) {
     f_type = type;
   }
@@ -48,26 +73,41 @@ void deepmd::prod_env_mat_a_cpu(FPTYPE *em,
     d_f_type[ii] = f_type[ii];
   }
 
-  // build nlist
-  std::vector<std::vector<int> > d_nlist_a(nloc);
+  // build nlist, unless it is kept in the cache
+  const bool reuse = reuse_nlist && cache.nloc == nloc && cache.nall == nall;
+  std::vector<std::vector<int> > &d_nlist_a = cache.nlist_a;
+  if (!reuse) {
+    cache.nloc = nloc;
+    cache.nall = nall;
+    d_nlist_a.resize(nloc);
+    cache.fmt_nlist_a.resize(nloc);
 
-  assert(nloc == inlist.inum);
-  for (unsigned ii = 0; ii < nloc; ++ii) {
-    d_nlist_a[ii].reserve(max_nbor_size);
-  }
-  for (unsigned ii = 0; ii < nloc; ++ii) {
-    int i_idx = inlist.ilist[ii];
-    for (unsigned jj = 0; jj < inlist.numneigh[ii]; ++jj) {
-      int j_idx = inlist.firstneigh[ii][jj];
-      d_nlist_a[i_idx].push_back(j_idx);
+    assert(nloc == inlist.inum);
+    for (unsigned ii = 0; ii < nloc; ++ii) {
+      d_nlist_a[ii].clear();
+      d_nlist_a[ii].reserve(max_nbor_size);
+    }
+    for (unsigned ii = 0; ii < nloc; ++ii) {
+      int i_idx = inlist.ilist[ii];
+      for (unsigned jj = 0; jj < inlist.numneigh[ii]; ++jj) {
+        int j_idx = inlist.firstneigh[ii][jj];
+        d_nlist_a[i_idx].push_back(j_idx);
+      }
     }
   }
 
 #pragma omp parallel for
   for (int ii = 0; ii < nloc; ++ii) {
-    std::vector<int> fmt_nlist_a;
-    int ret = format_nlist_i_cpu(fmt_nlist_a, d_coord3, d_f_type, ii,
-                                 d_nlist_a[ii], rcut, sec);
+    std::vector<int> &fmt_nlist_a = cache.fmt_nlist_a[ii];
+    if (cache.repair) {
+      reformat_nlist_i_cpu(fmt_nlist_a, d_nlist_a[ii], d_coord3, d_f_type, ii,
+                           rcut, sec, reuse);
+    } else if (!reuse || !check_fmt_nlist_i_cpu(fmt_nlist_a, d_coord3,
+                                                d_f_type, ii, d_nlist_a[ii],
+                                                rcut, sec)) {
+      format_nlist_i_cpu(fmt_nlist_a, d_coord3, d_f_type, ii, d_nlist_a[ii],
+                         rcut, sec);
+    }
     std::vector<FPTYPE> d_em_a;
     std::vector<FPTYPE> d_em_a_deriv;
     std::vector<FPTYPE> d_em_r;
@@ -208,6 +248,42 @@ template void deepmd::prod_env_mat_a_cpu<double>(double *em,
                                                  const std::vector<int> sec,
                                                  const int *f_type);
 
+template void deepmd::prod_env_mat_a_cpu<double>(double *em,
+                                                 double *em_deriv,
+                                                 double *rij,
+                                                 int *nlist,
+                                                 const double *coord,
+                                                 const int *type,
+                                                 const InputNlist &inlist,
+                                                 const int max_nbor_size,
+                                                 const double *avg,
+                                                 const double *std,
+                                                 const int nloc,
+                                                 const int nall,
+                                                 const float rcut,
+                                                 const float rcut_smth,
+                                                 const std::vector<int> sec,
+                                                 EnvMatNlistCache &cache,
+                                                 const bool reuse_nlist,
+                                                 const int *f_type);
+
+template void deepmd::prod_env_mat_a_cpu<float>(float *em,
+                                                float *em_deriv,
+                                                float *rij,
+                                                int *nlist,
+                                                const float *coord,
+                                                const int *type,
+                                                const InputNlist &inlist,
+                                                const int max_nbor_size,
+                                                const float *avg,
+                                                const float *std,
+                                                const int nloc,
+                                                const int nall,
+                                                const float rcut,
+                                                const float rcut_smth,
+                                                const std::vector<int> sec,
+                                                const int *f_type);
+
 template void deepmd::prod_env_mat_a_cpu<float>(float *em,
                                                 float *em_deriv,
                                                 float *rij,
@@ -223,6 +299,8 @@ template void deepmd::prod_env_mat_a_cpu<float>(float *em,
                                                 const float rcut,
                                                 const float rcut_smth,
                                                 const std::vector<int> sec,
+                                                EnvMatNlistCache &cache,
+                                                const bool reuse_nlist,
                                                 const int *f_type);
 
 template void deepmd::prod_env_mat_r_cpu<double>(double *em,
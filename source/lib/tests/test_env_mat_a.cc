@@ -592,6 +592,61 @@ TEST_F(TestEnvMatA, prod_cpu_equal_cpu) {
   // }
 }
 
+TEST_F(TestEnvMatA, prod_cpu_nlist_cache) {
+  int max_nbor_size = 0;
+  for (int ii = 0; ii < nlist_a_cpy.size(); ++ii) {
+    if (nlist_a_cpy[ii].size() > max_nbor_size) {
+      max_nbor_size = nlist_a_cpy[ii].size();
+    }
+  }
+  std::vector<int> ilist(nloc), numneigh(nloc);
+  std::vector<int *> firstneigh(nloc);
+  deepmd::InputNlist inlist(nloc, &ilist[0], &numneigh[0], &firstneigh[0]);
+  convert_nlist(inlist, nlist_a_cpy);
+  std::vector<double> avg(static_cast<size_t>(ntypes) * ndescrpt, 0);
+  std::vector<double> std(static_cast<size_t>(ntypes) * ndescrpt, 1);
+  // the first step builds the cache, the second step only moves the atoms
+  // slightly, the third step changes the order of the neighbors of atom 0,
+  // and the last step changes it back
+  std::vector<double> shift = {0., 0.01, 0.5, 0.};
+  // check the formatted neighbor lists, or repair the sorted neighbors
+  for (bool repair : {false, true}) {
+    deepmd::EnvMatNlistCache cache;
+    cache.repair = repair;
+    for (int step = 0; step < shift.size(); ++step) {
+      std::vector<double> posi_step(posi_cpy);
+      posi_step[0] += shift[step];
+      std::vector<double> em(static_cast<size_t>(nloc) * ndescrpt),
+          em_deriv(static_cast<size_t>(nloc) * ndescrpt * 3),
+          rij(static_cast<size_t>(nloc) * nnei * 3);
+      std::vector<int> nlist(static_cast<size_t>(nloc) * nnei);
+      deepmd::prod_env_mat_a_cpu(&em[0], &em_deriv[0], &rij[0], &nlist[0],
+                                 &posi_step[0], &atype_cpy[0], inlist,
+                                 max_nbor_size, &avg[0], &std[0], nloc, nall,
+                                 rc, rc_smth, sec_a);
+      std::vector<double> em_1(em.size()), em_deriv_1(em_deriv.size()),
+          rij_1(rij.size());
+      std::vector<int> nlist_1(nlist.size());
+      deepmd::prod_env_mat_a_cpu(&em_1[0], &em_deriv_1[0], &rij_1[0],
+                                 &nlist_1[0], &posi_step[0], &atype_cpy[0],
+                                 inlist, max_nbor_size, &avg[0], &std[0], nloc,
+                                 nall, rc, rc_smth, sec_a, cache, step > 0);
+      for (unsigned jj = 0; jj < em.size(); ++jj) {
+        EXPECT_EQ(em_1[jj], em[jj]);
+      }
+      for (unsigned jj = 0; jj < em_deriv.size(); ++jj) {
+        EXPECT_EQ(em_deriv_1[jj], em_deriv[jj]);
+      }
+      for (unsigned jj = 0; jj < rij.size(); ++jj) {
+        EXPECT_EQ(rij_1[jj], rij[jj]);
+      }
+      for (unsigned jj = 0; jj < nlist.size(); ++jj) {
+        EXPECT_EQ(nlist_1[jj], nlist[jj]);
+      }
+    }
+  }
+}
+
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 TEST_F(TestEnvMatA, prod_gpu) {
   EXPECT_EQ(nlist_r_cpy.size(), nloc);
@@ -139,12 +139,12 @@ void ComputeDeeptensorAtom::compute_peratom() {
   lmp_list.set_mask(NEIGHMASK);
 
   // declare outputs
-  std::vector<VALUETYPE> gtensor, force, virial, atensor, avirial;
+  std::vector<VALUETYPE> atensor;
 
   // compute tensors
+  // only the atomic tensor is stored, so the derivatives are not evaluated
   try {
-    dt.compute(gtensor, force, virial, atensor, avirial, dcoord, dtype, dbox,
-               nghost, lmp_list);
+    dt.compute(atensor, dcoord, dtype, dbox, nghost, lmp_list);
   } catch (deepmd_compat::deepmd_exception &e) {
     error->one(FLERR, e.what());
   }
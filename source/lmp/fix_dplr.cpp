@@ -31,6 +31,7 @@ static bool is_key(const string &input) {
   keys.push_back("bond_type");
   keys.push_back("efield");
   keys.push_back("pair_deepmd_index");
+  keys.push_back("pipeline");
   for (int ii = 0; ii < keys.size(); ++ii) {
     if (input == keys[ii]) {
       return true;
@@ -47,7 +48,9 @@ FixDPLR::FixDPLR(LAMMPS *lmp, int narg, char **arg)
       efield(3, 0.0),
       efield_fsum(4, 0.0),
       efield_fsum_all(4, 0.0),
-      efield_force_flag(0) {
+      efield_force_flag(0),
+      valid_pairs_flag(0),
+      pipeline(0) {
 #if LAMMPS_VERSION_NUMBER >= 20210210
   // lammps/lammps#2560
   energy_global_flag = 1;
@@ -133,12 +136,28 @@ FixDPLR::FixDPLR(LAMMPS *lmp, int narg, char **arg)
       }
       pair_deepmd_index = atoi(arg[iarg + 1]);
       iarg += 2;
+    } else if (string(arg[iarg]) == string("pipeline")) {
+      if (iarg + 1 >= narg) {
+        error->all(FLERR, "Illegal pipeline, not provided");
+      }
+      if (string(arg[iarg + 1]) == string("yes")) {
+        pipeline = 1;
+      } else if (string(arg[iarg + 1]) == string("no")) {
+        pipeline = 0;
+      } else {
+        error->all(FLERR, "Illegal pipeline, should be yes or no");
+      }
+      iarg += 2;
     } else {
       break;
     }
   }
   assert(map_vec.size() % 2 == 0 &&
          "number of ints provided by type_associate should be even");
+  wc_types.clear();
+  for (int ii = 0; ii < map_vec.size() / 2; ++ii) {
+    wc_types.push_back(map_vec[ii * 2 + 1]);
+  }
 
   // dpt.init(model);
   // dtm.init("frozen_model.pb");
@@ -223,6 +242,13 @@ FixDPLR::FixDPLR(LAMMPS *lmp, int narg, char **arg)
 /* ---------------------------------------------------------------------- */
 
 FixDPLR::~FixDPLR() {
+  if (dipole_future.valid()) {
+    dipole_future.wait();
+  }
+  PPPMDPLR *pppm_dplr = (PPPMDPLR *)force->kspace_match("pppm/dplr", 1);
+  if (pppm_dplr) {
+    pppm_dplr->set_fix_dplr(nullptr);
+  }
   delete[] xstr;
   delete[] ystr;
   delete[] zstr;
@@ -300,6 +326,25 @@ void FixDPLR::init() {
   } else {
     varflag = CONSTANT;
   }
+
+  // the pipelined dipole model moves the Wannier centroids while the
+  // short-range pair runs, so the pair should not see them
+  if (pipeline) {
+    for (int itype : wc_types) {
+      if (!pair_deepmd->is_type_ignored(itype)) {
+        error->all(FLERR,
+                   "Fix dplr pipeline requires pair deepmd to ignore the "
+                   "Wannier centroids of type {}, e.g. by NULL in pair_coeff",
+                   itype + 1);
+      }
+    }
+  }
+
+  // the pipelined dipole is waited for before the charges are spread
+  PPPMDPLR *pppm_dplr = (PPPMDPLR *)force->kspace_match("pppm/dplr", 1);
+  if (pppm_dplr) {
+    pppm_dplr->set_fix_dplr(pipeline ? this : nullptr);
+  }
 }
 
 /* ---------------------------------------------------------------------- */
@@ -307,12 +352,12 @@ void FixDPLR::init() {
 void FixDPLR::setup_post_neighbor() {
   double **x = atom->x;
 
-  vector<pair<int, int> > valid_pairs;
-  get_valid_pairs(valid_pairs, true);
+  vector<pair<int, int> > pairs;
+  get_valid_pairs(pairs, true);
 
-  for (int ii = 0; ii < valid_pairs.size(); ++ii) {
-    int idx0 = valid_pairs[ii].first;
-    int idx1 = valid_pairs[ii].second;
+  for (int ii = 0; ii < pairs.size(); ++ii) {
+    int idx0 = pairs[ii].first;
+    int idx1 = pairs[ii].second;
     int idx0_local = atom->map(atom->tag[idx0]);
     int idx1_local = atom->map(atom->tag[idx1]);
 
@@ -338,6 +383,8 @@ void FixDPLR::setup_post_neighbor() {
   }
 
   neighbor->build(1);
+  // the atoms are reordered by the rebuild
+  valid_pairs_flag = 0;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -444,8 +491,8 @@ void FixDPLR::pre_exchange() {
   int nghost = atom->nghost;
   int nall = nlocal + nghost;
 
-  vector<pair<int, int> > valid_pairs;
-  get_valid_pairs(valid_pairs, false);
+  // the indexes are still those of the last neighbor build
+  update_valid_pairs();
 
   for (int ii = 0; ii < valid_pairs.size(); ++ii) {
     int idx0 = valid_pairs[ii].first;
@@ -456,11 +503,44 @@ void FixDPLR::pre_exchange() {
       // v[idx1][dd] = 0.0;
     }
   }
+  // the atoms are exchanged and reordered after this
+  valid_pairs_flag = 0;
 }
 
 /* ---------------------------------------------------------------------- */
 
-void FixDPLR::pre_force(int vflag) {
+void FixDPLR::update_valid_pairs() {
+  if (valid_pairs_flag) {
+    return;
+  }
+  get_valid_pairs(valid_pairs, false);
+
+  int nlocal = atom->nlocal;
+  int nghost = atom->nghost;
+  int nall = nlocal + nghost;
+  vector<int> dtype(nall);
+  int *type = atom->type;
+  for (int ii = 0; ii < nall; ++ii) {
+    dtype[ii] = type_idx_map[type[ii] - 1];
+  }
+  // the coordinates are not used by the selection
+  vector<FLOAT_PREC> dcoord;
+  vector<int> sel_fwd, sel_bwd;
+  int sel_nghost;
+  deepmd_compat::select_by_type(sel_fwd, sel_bwd, sel_nghost, dcoord, dtype,
+                                nghost, sel_type);
+  // the deeptensor returns the selected atoms in their original order
+  valid_sel_idx.resize(valid_pairs.size());
+  for (int ii = 0; ii < valid_pairs.size(); ++ii) {
+    assert(valid_pairs[ii].first < sel_fwd.size());
+    valid_sel_idx[ii] = sel_fwd[valid_pairs[ii].first];
+  }
+  valid_pairs_flag = 1;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixDPLR::make_model_inputs() {
   double **x = atom->x;
   int *type = atom->type;
   int nlocal = atom->nlocal;
@@ -468,126 +548,116 @@ void FixDPLR::pre_force(int vflag) {
   int nall = nlocal + nghost;
 
   // mapping (for DPA-2 JAX)
-  std::vector<int> mapping_vec(nall, -1);
+  mapping_buff.assign(nall, -1);
   if (comm->nprocs == 1 && atom->map_style != Atom::MAP_NONE) {
     for (size_t ii = 0; ii < nall; ++ii) {
-      mapping_vec[ii] = atom->map(atom->tag[ii]);
+      mapping_buff[ii] = atom->map(atom->tag[ii]);
     }
   }
-
-  // if (eflag_atom) {
-  //   error->all(FLERR,"atomic energy calculation is not supported by this
-  //   fix\n");
-  // }
-
-  // declear inputs
-  vector<int> dtype(nall);
-  vector<FLOAT_PREC> dbox(9, 0);
-  vector<FLOAT_PREC> dcoord(nall * 3, 0.);
   // get type
+  dtype_buff.resize(nall);
   for (int ii = 0; ii < nall; ++ii) {
-    dtype[ii] = type_idx_map[type[ii] - 1];
+    dtype_buff[ii] = type_idx_map[type[ii] - 1];
   }
   // get box
-  dbox[0] = domain->h[0] / dist_unit_cvt_factor;  // xx
-  dbox[4] = domain->h[1] / dist_unit_cvt_factor;  // yy
-  dbox[8] = domain->h[2] / dist_unit_cvt_factor;  // zz
-  dbox[7] = domain->h[3] / dist_unit_cvt_factor;  // zy
-  dbox[6] = domain->h[4] / dist_unit_cvt_factor;  // zx
-  dbox[3] = domain->h[5] / dist_unit_cvt_factor;  // yx
+  dbox_buff.assign(9, 0.);
+  dbox_buff[0] = domain->h[0] / dist_unit_cvt_factor;  // xx
+  dbox_buff[4] = domain->h[1] / dist_unit_cvt_factor;  // yy
+  dbox_buff[8] = domain->h[2] / dist_unit_cvt_factor;  // zz
+  dbox_buff[7] = domain->h[3] / dist_unit_cvt_factor;  // zy
+  dbox_buff[6] = domain->h[4] / dist_unit_cvt_factor;  // zx
+  dbox_buff[3] = domain->h[5] / dist_unit_cvt_factor;  // yx
   // get coord
+  dcoord_buff.resize(static_cast<size_t>(nall) * 3);
   for (int ii = 0; ii < nall; ++ii) {
     for (int dd = 0; dd < 3; ++dd) {
-      dcoord[ii * 3 + dd] =
+      dcoord_buff[ii * 3 + dd] =
           (x[ii][dd] - domain->boxlo[dd]) / dist_unit_cvt_factor;
     }
   }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixDPLR::compute_dipole(int nghost, NeighList *list) {
   // get lammps nlist
-  NeighList *list = pair_deepmd->list;
   deepmd_compat::InputNlist lmp_list(list->inum, list->ilist, list->numneigh,
                                      list->firstneigh);
   lmp_list.set_mask(NEIGHMASK);
   if (comm->nprocs == 1 && atom->map_style != Atom::MAP_NONE) {
-    lmp_list.set_mapping(mapping_vec.data());
+    lmp_list.set_mapping(mapping_buff.data());
+  }
+  dpt.compute(dipole_buff, dcoord_buff, dtype_buff, dbox_buff, nghost,
+              lmp_list);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixDPLR::pre_force(int vflag) {
+  // if (eflag_atom) {
+  //   error->all(FLERR,"atomic energy calculation is not supported by this
+  //   fix\n");
+  // }
+
+  make_model_inputs();
+  NeighList *list = pair_deepmd->list;
+  if (pipeline) {
+    // the Wannier centroids are only needed by the kspace, so the dipole
+    // model runs alongside the short-range pair, which ignores them
+    dipole_future = std::async(std::launch::async, &FixDPLR::compute_dipole,
+                               this, atom->nghost, list);
+    return;
   }
-  // declear output
-  vector<FLOAT_PREC> tensor;
-  // compute
   try {
-    dpt.compute(tensor, dcoord, dtype, dbox, nghost, lmp_list);
+    compute_dipole(atom->nghost, list);
   } catch (deepmd_compat::deepmd_exception &e) {
     error->one(FLERR, e.what());
   }
-  // cout << "tensor of size " << tensor.size() << endl;
-  // cout << "nghost " << nghost << endl;
-  // cout << "nall " << dtype.size() << endl;
-  // cout << "nloc " << nlocal << endl;
-  // for (int ii = 0; ii < tensor.size(); ++ii){
-  //   if (ii%3 == 0){
-  //     cout << endl;
-  //   }
-  //   cout << tensor[ii] << "\t";
-  // }
-  // cout << endl;
-  // for (int ii = 0; ii < nlocal * 3; ++ii){
-  //   if (ii%3 == 0){
-  //     cout << endl;
-  //   }
-  //   cout << dcoord[ii] << "\t";
-  // }
-  // int max_type = 0;
-  // for (int ii = 0; ii < dtype.size(); ++ii){
-  //   if (dtype[ii] > max_type) {
-  //     max_type = dtype[ii];
-  //   }
-  // }
+  apply_dipole();
+}
 
-  vector<int> sel_fwd, sel_bwd;
-  int sel_nghost;
-  deepmd_compat::select_by_type(sel_fwd, sel_bwd, sel_nghost, dcoord, dtype,
-                                nghost, sel_type);
-  int sel_nall = sel_bwd.size();
-  int sel_nloc = sel_nall - sel_nghost;
-  vector<int> sel_type(sel_bwd.size());
-  deepmd_compat::select_map<int>(sel_type, dtype, sel_fwd, 1);
+/* ---------------------------------------------------------------------- */
 
-  // Yixiao: because the deeptensor already return the correct order, the
-  // following map is no longer needed deepmd_compat::AtomMap<FLOAT_PREC>
-  // atom_map(sel_type.begin(), sel_type.begin() + sel_nloc); const
-  // vector<int> & sort_fwd_map(atom_map.get_fwd_map());
+void FixDPLR::wait_dipole() {
+  if (!dipole_future.valid()) {
+    return;
+  }
+  try {
+    dipole_future.get();
+  } catch (deepmd_compat::deepmd_exception &e) {
+    error->one(FLERR, e.what());
+  }
+  apply_dipole();
+}
 
-  vector<pair<int, int> > valid_pairs;
-  get_valid_pairs(valid_pairs, false);
+/* ---------------------------------------------------------------------- */
+
+void FixDPLR::apply_dipole() {
+  double **x = atom->x;
+  const vector<FLOAT_PREC> &tensor = dipole_buff;
+
+  update_valid_pairs();
 
   int odim = dpt.output_dim();
   assert(odim == 3);
-  dipole_recd.resize(static_cast<size_t>(nall) * 3);
-  fill(dipole_recd.begin(), dipole_recd.end(), 0.0);
+  // the dipole of each valid pair, in the order of the pairs
+  dipole_recd.resize(valid_pairs.size() * 3);
   for (int ii = 0; ii < valid_pairs.size(); ++ii) {
     int idx0 = valid_pairs[ii].first;
     int idx1 = valid_pairs[ii].second;
-    assert(idx0 < sel_fwd.size());  // && sel_fwd[idx0] < sort_fwd_map.size());
-    // Yixiao: the sort map is no longer needed
-    // int res_idx = sort_fwd_map[sel_fwd[idx0]];
-    int res_idx = sel_fwd[idx0];
-    // int ret_idx = dpl_bwd[res_idx];
+    int res_idx = valid_sel_idx[ii];
     atom->image[idx1] = atom->image[idx0];
     for (int dd = 0; dd < 3; ++dd) {
       x[idx1][dd] =
           x[idx0][dd] + tensor[res_idx * 3 + dd] * dist_unit_cvt_factor;
       // res_buff[idx1 * odim + dd] = tensor[res_idx * odim + dd];
-      dipole_recd[idx0 * 3 + dd] =
+      dipole_recd[ii * 3 + dd] =
           tensor[res_idx * 3 + dd] * dist_unit_cvt_factor;
+      // the modifier in post_force sees the moved Wannier centroid
+      dcoord_buff[idx1 * 3 + dd] =
+          (x[idx1][dd] - domain->boxlo[dd]) / dist_unit_cvt_factor;
     }
   }
-  // cout << "-------------------- fix/dplr: pre force " << endl;
-  // for (int ii = 0; ii < nlocal; ++ii){
-  //   cout << ii << "    ";
-  //   for (int dd = 0; dd < 3; ++dd){
-  //     cout << x[ii][dd] << " " ;
-  //   }
-  //   cout << endl;
-  // }
 }
 
 /* ---------------------------------------------------------------------- */
@@ -607,33 +677,23 @@ void FixDPLR::post_force(int vflag) {
     update_efield_variables();
   }
 
+  // no-op unless the dipole is pipelined and there is no pppm/dplr
+  wait_dipole();
+
   PPPMDPLR *pppm_dplr = (PPPMDPLR *)force->kspace_match("pppm/dplr", 1);
   int nlocal = atom->nlocal;
   int nghost = atom->nghost;
   int nall = nlocal + nghost;
-  vector<FLOAT_PREC> dcoord(nall * 3, 0.0), dbox(9, 0.0),
-      dfele(nlocal * 3, 0.0);
-  vector<int> dtype(nall, 0);
-  // set values for dcoord, dbox, dfele
+  // the types, box, and coordinates (including the Wannier centroids moved
+  // by apply_dipole) are reused from pre_force
+  const vector<FLOAT_PREC> &dcoord = dcoord_buff;
+  const vector<FLOAT_PREC> &dbox = dbox_buff;
+  const vector<int> &dtype = dtype_buff;
+  assert(dcoord.size() == static_cast<size_t>(nall) * 3);
+  vector<FLOAT_PREC> dfele(nlocal * 3, 0.0);
+  // set values for dfele
   {
-    int *type = atom->type;
-    for (int ii = 0; ii < nall; ++ii) {
-      dtype[ii] = type_idx_map[type[ii] - 1];
-    }
-    dbox[0] = domain->h[0] / dist_unit_cvt_factor;  // xx
-    dbox[4] = domain->h[1] / dist_unit_cvt_factor;  // yy
-    dbox[8] = domain->h[2] / dist_unit_cvt_factor;  // zz
-    dbox[7] = domain->h[3] / dist_unit_cvt_factor;  // zy
-    dbox[6] = domain->h[4] / dist_unit_cvt_factor;  // zx
-    dbox[3] = domain->h[5] / dist_unit_cvt_factor;  // yx
-    // get coord
     double **x = atom->x;
-    for (int ii = 0; ii < nall; ++ii) {
-      for (int dd = 0; dd < 3; ++dd) {
-        dcoord[ii * 3 + dd] =
-            (x[ii][dd] - domain->boxlo[dd]) / dist_unit_cvt_factor;
-      }
-    }
     // revise force according to efield
     if (pppm_dplr) {
       const vector<double> &dfele_(pppm_dplr->get_fele());
@@ -679,8 +739,7 @@ void FixDPLR::post_force(int vflag) {
   deepmd_compat::InputNlist lmp_list(list->inum, list->ilist, list->numneigh,
                                      list->firstneigh);
   // bonded pairs
-  vector<pair<int, int> > valid_pairs;
-  get_valid_pairs(valid_pairs, false);
+  update_valid_pairs();
   // output vects
   vector<FLOAT_PREC> dfcorr, dvcorr;
   // compute
@@ -743,7 +802,7 @@ void FixDPLR::post_force(int vflag) {
     for (int dd0 = 0; dd0 < 3; ++dd0) {
       for (int dd1 = 0; dd1 < 3; ++dd1) {
         dvcorr[dd0 * 3 + dd1] -=
-            dfele[idx1 * 3 + dd0] * dipole_recd[idx0 * 3 + dd1];
+            dfele[idx1 * 3 + dd0] * dipole_recd[ii * 3 + dd1];
       }
     }
   }
@@ -10,6 +10,7 @@ FixStyle(dplr, FixDPLR)
 
 #include <stdio.h>
 
+#include <future>
 #include <map>
 
 #include "fix.h"
@@ -56,6 +57,7 @@ class FixDPLR : public Fix {
   void unpack_reverse_comm(int, int *, double *) override;
   double compute_scalar(void) override;
   double compute_vector(int) override;
+  void wait_dipole();
   double ener_unit_cvt_factor, dist_unit_cvt_factor, force_unit_cvt_factor;
 
  private:
@@ -70,11 +72,30 @@ class FixDPLR : public Fix {
   std::map<int, int> type_asso;
   std::map<int, int> bk_type_asso;
   std::vector<FLOAT_PREC> dipole_recd;
+  // inputs of the models, shared by pre_force and post_force of a step
+  std::vector<int> dtype_buff;
+  std::vector<FLOAT_PREC> dbox_buff;
+  std::vector<FLOAT_PREC> dcoord_buff;
+  std::vector<int> mapping_buff;
+  std::vector<FLOAT_PREC> dipole_buff;
+  int pipeline;
+  // the LAMMPS types of the Wannier centroids, starting from 0
+  std::vector<int> wc_types;
+  std::future<void> dipole_future;
+  void make_model_inputs();
+  void compute_dipole(int nghost, class NeighList *list);
+  void apply_dipole();
   std::vector<double> dfcorr_buff;
   std::vector<double> efield;
   std::vector<double> efield_fsum, efield_fsum_all;
   int efield_force_flag;
   void get_valid_pairs(std::vector<std::pair<int, int> > &pairs, bool is_setup);
+  // the valid pairs and the indexes of their real atoms in the output of the
+  // DW model, kept until the atoms are reordered at the next reneighboring
+  std::vector<std::pair<int, int> > valid_pairs;
+  std::vector<int> valid_sel_idx;
+  int valid_pairs_flag;
+  void update_valid_pairs();
   int varflag;
   char *xstr, *ystr, *zstr;
   int xvar, yvar, zvar, xstyle, ystyle, zstyle;
@@ -1,11 +1,17 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 #include <string.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <numeric>
 #include <sstream>
 
 #include "atom.h"
@@ -51,7 +57,7 @@ static int stringCmp(const void *a, const void *b) {
   return sum;
 }
 
-int PairDeepBaseModel::get_node_rank() {
+int PairDeepBaseModel::get_node_rank(int *node_nranks, MPI_Comm *node_comm) {
   char host_name[MPI_MAX_PROCESSOR_NAME];
   memset(host_name, '\0', sizeof(char) * MPI_MAX_PROCESSOR_NAME);
   char(*host_names)[MPI_MAX_PROCESSOR_NAME];
@@ -89,44 +95,215 @@ int PairDeepBaseModel::get_node_rank() {
 
   MPI_Comm_split(MPI_COMM_WORLD, color, 0, &nodeComm);
   MPI_Comm_rank(nodeComm, &myrank);
+  if (node_nranks != nullptr) {
+    MPI_Comm_size(nodeComm, node_nranks);
+  }
 
   MPI_Barrier(MPI_COMM_WORLD);
   int looprank = myrank;
   // printf (" Assigning device %d  to process on node %s rank %d,
   // OK\n",looprank,  host_name, rank );
   free(host_names);
+  // the caller frees the communicator of the node if it asks for it
+  if (node_comm != nullptr) {
+    *node_comm = nodeComm;
+  } else {
+    MPI_Comm_free(&nodeComm);
+  }
   return looprank;
 }
 
-std::string PairDeepBaseModel::get_file_content(const std::string &model) {
-  int myrank = 0, root = 0;
-  MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
-  int nchar = 0;
-  std::string file_content;
-  if (myrank == root) {
-    deepmd_compat::read_file_to_string(model, file_content);
-    nchar = file_content.size();
+int PairDeepBaseModel::get_ago(bigint &nlist_seen) {
+  // a model that missed a neighbor list build has to rebuild its own
+  int ago = nlist_seen == nlist_build ? neighbor->ago : 0;
+  nlist_seen = nlist_build;
+  return ago;
+}
+
+// the timing of all the pair styles of a LAMMPS instance, e.g. the
+// sub-styles of pair hybrid, is summed up and printed when the last of them
+// is deleted
+struct PairTiming {
+  int ninstances = 0;
+  double time[3] = {0., 0., 0.};
+  bigint ncalls = 0;
+};
+static std::map<LAMMPS *, PairTiming> pair_timings;
+
+void PairDeepBaseModel::print_timing() {
+  PairTiming &timing = pair_timings[lmp];
+  timing.time[0] += time_pre;
+  timing.time[1] += time_model;
+  timing.time[2] += time_post;
+  timing.ncalls += time_ncalls;
+  if (--timing.ninstances > 0) {
+    return;
   }
-  MPI_Bcast(&nchar, 1, MPI_INT, root, MPI_COMM_WORLD);
-  char *buff = (char *)malloc(sizeof(char) * nchar);
-  if (myrank == root) {
-    memcpy(buff, file_content.c_str(), sizeof(char) * nchar);
+  const bigint ncalls = timing.ncalls;
+  double sum[3], max[3];
+  MPI_Reduce(timing.time, sum, 3, MPI_DOUBLE, MPI_SUM, 0, world);
+  MPI_Reduce(timing.time, max, 3, MPI_DOUBLE, MPI_MAX, 0, world);
+  pair_timings.erase(lmp);
+  // comm may already be deleted when LAMMPS is destroyed
+  int me, nprocs;
+  MPI_Comm_rank(world, &me);
+  MPI_Comm_size(world, &nprocs);
+  if (me == 0 && ncalls > 0) {
+    const char *names[3] = {"pre-processing", "model", "post-processing"};
+    std::stringstream buffer;
+    buffer << "DeePMD-kit: time of " << ncalls
+           << " pair computations (s, average/max over ranks):\n";
+    buffer << std::fixed << std::setprecision(4);
+    for (int ii = 0; ii < 3; ++ii) {
+      buffer << "  " << std::left << std::setw(16) << names[ii] << std::right
+             << std::setw(12) << sum[ii] / nprocs << std::setw(12) << max[ii]
+             << "\n";
+    }
+    utils::logmesg(lmp, buffer.str());
+  }
+}
+
+void PairDeepBaseModel::bind_node_cores(const int node_rank,
+                                        const int node_nranks,
+                                        MPI_Comm node_comm) {
+  // opt-in: bind each rank to its share of the cores on the node before the
+  // models create their thread pools
+  const char *env_affinity = std::getenv("DP_CORE_AFFINITY");
+  if (env_affinity == nullptr || std::string(env_affinity) == "0") {
+    return;
+  }
+  int ncores = 0;
+#if defined(__linux__)
+  // the ranks on a node have the same cores unless the launcher has bound
+  // them, which is detected from the cores usable by each rank, so that a
+  // cpuset or a cgroup limiting the whole job does not disable the binding
+  cpu_set_t mask, mask_and, mask_or;
+  CPU_ZERO(&mask);
+  sched_getaffinity(0, sizeof(cpu_set_t), &mask);
+  MPI_Allreduce(&mask, &mask_and, sizeof(cpu_set_t), MPI_BYTE, MPI_BAND,
+                node_comm);
+  MPI_Allreduce(&mask, &mask_or, sizeof(cpu_set_t), MPI_BYTE, MPI_BOR,
+                node_comm);
+  if (CPU_EQUAL(&mask_and, &mask_or)) {
+    ncores = deepmd_compat::bind_node_cores(node_rank, node_nranks);
+  }
+#endif
+  if (comm->me == 0) {
+    if (ncores > 0) {
+      utils::logmesg(lmp, "DeePMD-kit: bind each rank to " +
+                              std::to_string(ncores) + " cores\n");
+    } else {
+      utils::logmesg(lmp,
+                     "DeePMD-kit: the cores are not bound, as the process "
+                     "has been bound or the platform is not supported\n");
+    }
   }
-  MPI_Bcast(buff, nchar, MPI_CHAR, root, MPI_COMM_WORLD);
-  file_content.resize(nchar);
-  for (unsigned ii = 0; ii < nchar; ++ii) {
-    file_content[ii] = buff[ii];
+}
+
+// the number of bytes in one broadcast, which is within the range of int
+static const long long bcast_chunk_size = 1LL << 30;
+
+// broadcast a buffer in chunks, so that the buffer can be larger than 2 GB;
+// the requests are appended to wait for
+static void ibcast_chunked(char *buff,
+                           const long long size,
+                           const int root,
+                           MPI_Comm comm,
+                           std::vector<MPI_Request> &requests) {
+  for (long long offset = 0; offset < size; offset += bcast_chunk_size) {
+    const int count = std::min(bcast_chunk_size, size - offset);
+    MPI_Request request;
+    MPI_Ibcast(buff + offset, count, MPI_CHAR, root, comm, &request);
+    requests.push_back(request);
   }
-  free(buff);
-  return file_content;
+}
+
+std::string PairDeepBaseModel::get_file_content(const std::string &model) {
+  return get_file_content(std::vector<std::string>(1, model))[0];
 }
 
 std::vector<std::string> PairDeepBaseModel::get_file_content(
     const std::vector<std::string> &models) {
-  std::vector<std::string> file_contents(models.size());
-  for (unsigned ii = 0; ii < models.size(); ++ii) {
-    file_contents[ii] = get_file_content(models[ii]);
+  const int nmodels = models.size();
+  std::vector<std::string> file_contents(nmodels);
+  int myrank = 0, root = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+  std::vector<long long> sizes(nmodels, 0);
+  if (myrank == root) {
+    for (int ii = 0; ii < nmodels; ++ii) {
+      // a memmapped model is mapped from the file by each process, so that
+      // the processes on a node share its pages
+      if (deepmd_compat::is_memmapped_model(models[ii])) {
+        continue;
+      }
+      deepmd_compat::read_file_to_string(models[ii], file_contents[ii]);
+      sizes[ii] = file_contents[ii].size();
+    }
+  }
+  MPI_Bcast(sizes.data(), nmodels, MPI_LONG_LONG, root, MPI_COMM_WORLD);
+  const long long total_size =
+      std::accumulate(sizes.begin(), sizes.end(), 0LL);
+  if (total_size == 0) {
+    return file_contents;
+  }
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+  // the models are broadcast among the leaders of the nodes, and then shared
+  // with the other ranks on each node through a shared memory segment; the
+  // root is the leader of its node since the ranks are split in order
+  MPI_Comm node_comm, leader_comm;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, myrank,
+                      MPI_INFO_NULL, &node_comm);
+  int node_rank;
+  MPI_Comm_rank(node_comm, &node_rank);
+  MPI_Comm_split(MPI_COMM_WORLD, node_rank == 0 ? 0 : MPI_UNDEFINED, myrank,
+                 &leader_comm);
+  char *shared_buff = nullptr;
+  MPI_Win win;
+  MPI_Win_allocate_shared(node_rank == 0 ? total_size : 0, 1, MPI_INFO_NULL,
+                          node_comm, &shared_buff, &win);
+  if (node_rank != 0) {
+    MPI_Aint shared_size;
+    int disp_unit;
+    MPI_Win_shared_query(win, 0, &shared_size, &disp_unit, &shared_buff);
+  }
+  MPI_Win_fence(0, win);
+  if (leader_comm != MPI_COMM_NULL) {
+    std::vector<MPI_Request> requests;
+    long long offset = 0;
+    for (int ii = 0; ii < nmodels; ++ii) {
+      if (myrank == root) {
+        memcpy(shared_buff + offset, file_contents[ii].data(), sizes[ii]);
+      }
+      // the broadcasts of all models overlap with each other
+      ibcast_chunked(shared_buff + offset, sizes[ii], 0, leader_comm,
+                     requests);
+      offset += sizes[ii];
+    }
+    MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+    MPI_Comm_free(&leader_comm);
+  }
+  MPI_Win_fence(0, win);
+  if (myrank != root) {
+    long long offset = 0;
+    for (int ii = 0; ii < nmodels; ++ii) {
+      file_contents[ii].assign(shared_buff + offset, sizes[ii]);
+      offset += sizes[ii];
+    }
   }
+  MPI_Win_fence(0, win);
+  MPI_Win_free(&win);
+  MPI_Comm_free(&node_comm);
+#else
+  for (int ii = 0; ii < nmodels; ++ii) {
+    file_contents[ii].resize(sizes[ii]);
+    for (long long offset = 0; offset < sizes[ii];
+         offset += bcast_chunk_size) {
+      const int count = std::min(bcast_chunk_size, sizes[ii] - offset);
+      MPI_Bcast(&file_contents[ii][offset], count, MPI_CHAR, root,
+                MPI_COMM_WORLD);
+    }
+  }
+#endif
   return file_contents;
 }
 
@@ -180,6 +357,9 @@ void PairDeepBaseModel::make_aparam_from_compute(vector<double> &aparam) {
     aparam.assign(cvector, cvector + nlocal);
   } else if (dim_aparam > 1) {
     double **carray = compute->array_atom;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
     for (int ii = 0; ii < nlocal; ++ii) {
       for (int jj = 0; jj < dim_aparam; ++jj) {
         aparam[ii * dim_aparam + jj] = carray[ii][jj];
@@ -337,6 +517,14 @@ PairDeepBaseModel::PairDeepBaseModel(
   single_model = false;
   multi_models_mod_devi = false;
   multi_models_no_mod_devi = false;
+  nlist_build = 0;
+  single_nlist_build = -1;
+  multi_nlist_build = -1;
+  time_pre = 0.;
+  time_model = 0.;
+  time_post = 0.;
+  time_ncalls = 0;
+  ++pair_timings[lmp].ninstances;
   is_restart = false;
   // set comm size needed by this Pair
   comm_reverse = 1;
@@ -370,6 +558,7 @@ void PairDeepBaseModel::print_summary(const string pre) const {
 }
 
 PairDeepBaseModel::~PairDeepBaseModel() {
+  print_timing();
   if (allocated) {
     memory->destroy(setflag);
     memory->destroy(cutsq);
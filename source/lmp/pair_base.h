@@ -41,7 +41,10 @@ class PairDeepBaseModel : public Pair {
   void read_restart(FILE *) override;
   double init_one(int i, int j) override;
   void print_summary(const std::string pre) const;
-  int get_node_rank();
+  int get_node_rank(int *node_nranks = nullptr, MPI_Comm *node_comm = nullptr);
+  void bind_node_cores(const int node_rank,
+                       const int node_nranks,
+                       MPI_Comm node_comm);
   void cum_sum(std::map<int, int> &, std::map<int, int> &);
 
   std::string get_file_content(const std::string &model);
@@ -72,6 +75,19 @@ class PairDeepBaseModel : public Pair {
   bool single_model;
   bool multi_models_mod_devi;
   bool multi_models_no_mod_devi;
+  // the first model and the ensemble keep their own neighbor lists, which
+  // are valid only if they have seen the latest neighbor list build
+  bigint nlist_build;
+  bigint single_nlist_build;
+  bigint multi_nlist_build;
+  int get_ago(bigint &nlist_seen);
+  // wall time of compute before, inside, and after the model calls, which is
+  // printed when the pair style is deleted
+  double time_pre;
+  double time_model;
+  double time_post;
+  bigint time_ncalls;
+  void print_timing();
   bool is_restart;
   std::vector<double> virtual_len;
   std::vector<double> spin_norm;
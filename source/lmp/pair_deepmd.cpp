@@ -2,6 +2,7 @@
 #include <string.h>
 
 #include <cassert>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -119,11 +120,19 @@ static const char cite_user_deepmd_package[] =
 PairDeepMD::PairDeepMD(LAMMPS *lmp)
     : PairDeepBaseModel(
           lmp, cite_user_deepmd_package, deep_pot, deep_pot_model_devi) {
-  // Constructor body can be empty
+  atomic_threshold = 0.;
+  atomic_file_opened = false;
+  atomic_offset = 0;
+  skip_devi_threshold = 0.;
+  skip_devi_max = 0;
+  skip_devi_from = -1;
+  skip_devi_until = -1;
 }
 
 PairDeepMD::~PairDeepMD() {
-  // Ensure base class destructor is called
+  if (atomic_file_opened) {
+    MPI_File_close(&atomic_fh);
+  }
 }
 
 void PairDeepMD::compute(int eflag, int vflag) {
@@ -133,6 +142,8 @@ void PairDeepMD::compute(int eflag, int vflag) {
   // See
   // https://docs.lammps.org/Developer_updating.html#use-ev-init-to-initialize-variables-derived-from-eflag-and-vflag
   ev_init(eflag, vflag);
+  const double time_start = MPI_Wtime();
+  double time_model_call = 0.;
   if (vflag_atom) {
     error->all(FLERR,
                "6-element atomic virial is not supported. Use compute "
@@ -159,15 +170,23 @@ void PairDeepMD::compute(int eflag, int vflag) {
         "style 'deepspin' instead.");
   }
 
-  vector<int> dtype(nall);
+  // the workspaces are members, which keep their capacity between steps
+  vector<int> &dtype = dtype_buff;
+  dtype.resize(nall);
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
   for (int ii = 0; ii < nall; ++ii) {
     dtype[ii] = type_idx_map[type[ii] - 1];
   }
 
   double dener(0);
-  vector<double> dforce(nall * 3);
-  vector<double> dvirial(9, 0);
-  vector<double> dcoord(nall * 3, 0.);
+  vector<double> &dforce = dforce_buff;
+  dforce.resize(nall * 3);
+  vector<double> &dvirial = dvirial_buff;
+  dvirial.assign(9, 0);
+  vector<double> &dcoord = dcoord_buff;
+  dcoord.resize(nall * 3);
   vector<double> dbox(9, 0);
   vector<double> daparam;
 
@@ -179,22 +198,46 @@ void PairDeepMD::compute(int eflag, int vflag) {
   dbox[6] = domain->h[4] / dist_unit_cvt_factor;  // zx
   dbox[3] = domain->h[5] / dist_unit_cvt_factor;  // yx
 
-  // get coord
-  for (int ii = 0; ii < nall; ++ii) {
-    for (int dd = 0; dd < 3; ++dd) {
-      dcoord[ii * 3 + dd] =
-          (x[ii][dd] - domain->boxlo[dd]) / dist_unit_cvt_factor;
+  // get coord, shifted and scaled in one pass over the contiguous array of
+  // LAMMPS; the constants are copied so that they are not reloaded
+  if (nall > 0) {
+    const double *xx = x[0];
+    double *cc = dcoord.data();
+    const double lo0 = domain->boxlo[0];
+    const double lo1 = domain->boxlo[1];
+    const double lo2 = domain->boxlo[2];
+    const double dist_cvt = dist_unit_cvt_factor;
+#if defined(_OPENMP)
+#pragma omp parallel for simd num_threads(comm->nthreads)
+#endif
+    for (int ii = 0; ii < nall; ++ii) {
+      cc[ii * 3 + 0] = (xx[ii * 3 + 0] - lo0) / dist_cvt;
+      cc[ii * 3 + 1] = (xx[ii * 3 + 1] - lo1) / dist_cvt;
+      cc[ii * 3 + 2] = (xx[ii * 3 + 2] - lo2) / dist_cvt;
     }
   }
 
   // mapping (for DPA-2 JAX)
-  std::vector<int> mapping_vec(nall, -1);
   if (comm->nprocs == 1 && atom->map_style != Atom::MAP_NONE) {
-    for (size_t ii = 0; ii < nall; ++ii) {
-      mapping_vec[ii] = atom->map(atom->tag[ii]);
+    mapping_buff.resize(nall);
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
+    for (int ii = 0; ii < nall; ++ii) {
+      mapping_buff[ii] = atom->map(atom->tag[ii]);
     }
   }
 
+  // the forces are written into atom->f by the model if they are neither
+  // scaled nor converted, this is the only pair style, and no fix is invoked
+  // before the pair style, so that atom->f has only been cleared and the
+  // forces of other styles and fixes are added later
+  const bool write_force =
+      nall > 0 && force->pair == this && scale[1][1] == 1.0 &&
+      force_unit_cvt_factor == 1.0 && modify->n_pre_force == 0 &&
+      modify->n_min_pre_force == 0;
+  bool force_written = false;
+
   if (do_compute_aparam) {
     make_aparam_from_compute(daparam);
   } else if (aparam.size() > 0) {
@@ -214,23 +257,21 @@ void PairDeepMD::compute(int eflag, int vflag) {
     make_fparam_from_compute(fparam);
   }
 
-  // int ago = numb_models > 1 ? 0 : neighbor->ago;
-  int ago = neighbor->ago;
-  if (numb_models > 1) {
-    if (multi_models_no_mod_devi &&
-        (out_freq > 0 && update->ntimestep % out_freq == 0)) {
-      ago = 0;
-    } else if (multi_models_mod_devi &&
-               (out_freq == 0 || update->ntimestep % out_freq != 0)) {
-      ago = 0;
-    }
+  if (neighbor->ago == 0) {
+    ++nlist_build;
   }
   // compute
+  const bigint ntimestep = update->ntimestep;
+  const bool skip_devi =
+      ntimestep > skip_devi_from && ntimestep <= skip_devi_until;
   single_model = (numb_models == 1);
-  multi_models_no_mod_devi =
-      (numb_models > 1 && (out_freq == 0 || update->ntimestep % out_freq != 0));
-  multi_models_mod_devi =
-      (numb_models > 1 && (out_freq > 0 && update->ntimestep % out_freq == 0));
+  multi_models_mod_devi = (numb_models > 1 && out_freq > 0 &&
+                           ntimestep % out_freq == 0 && !skip_devi);
+  multi_models_no_mod_devi = (numb_models > 1 && !multi_models_mod_devi);
+  int ago = multi_models_mod_devi ? get_ago(multi_nlist_build)
+                                  : get_ago(single_nlist_build);
+  const double time_pre_end = MPI_Wtime();
+  time_pre += time_pre_end - time_start;
   if (do_ghost) {
     deepmd_compat::InputNlist lmp_list(
         list->inum, list->ilist, list->numneigh, list->firstneigh,
@@ -239,30 +280,43 @@ void PairDeepMD::compute(int eflag, int vflag) {
         commdata_->recvproc, &world);
     lmp_list.set_mask(NEIGHMASK);
     if (comm->nprocs == 1 && atom->map_style != Atom::MAP_NONE) {
-      lmp_list.set_mapping(mapping_vec.data());
+      lmp_list.set_mapping(mapping_buff.data());
     }
     deepmd_compat::InputNlist extend_lmp_list;
     if (single_model || multi_models_no_mod_devi) {
       // cvflag_atom is the right flag for the cvatom matrix
       if (!(eflag_atom || cvflag_atom)) {
+        // skip the virial if it is not tallied at this step
+        double *dvirial_ = vflag ? dvirial.data() : nullptr;
+        double *dforce_ = write_force ? f[0] : dforce.data();
+        const double time_call = MPI_Wtime();
         try {
-          deep_pot.compute(dener, dforce, dvirial, dcoord, dtype, dbox, nghost,
-                           lmp_list, ago, fparam, daparam);
+          deep_pot.compute(dener, dforce_, dvirial_,
+                           static_cast<double *>(nullptr),
+                           static_cast<double *>(nullptr), dcoord, dtype, dbox,
+                           nghost, lmp_list, ago, fparam, daparam);
         } catch (deepmd_compat::deepmd_exception &e) {
           error->one(FLERR, e.what());
         }
+        time_model_call += MPI_Wtime() - time_call;
+        force_written = write_force;
       }
       // do atomic energy and virial
       else {
         vector<double> deatom(nall * 1, 0);
         vector<double> dvatom(nall * 9, 0);
+        const double time_call = MPI_Wtime();
         try {
           deep_pot.compute(dener, dforce, dvirial, deatom, dvatom, dcoord,
                            dtype, dbox, nghost, lmp_list, ago, fparam, daparam);
         } catch (deepmd_compat::deepmd_exception &e) {
           error->one(FLERR, e.what());
         }
+        time_model_call += MPI_Wtime() - time_call;
         if (eflag_atom) {
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
           for (int ii = 0; ii < nlocal; ++ii) {
             eatom[ii] += scale[1][1] * deatom[ii] * ener_unit_cvt_factor;
           }
@@ -271,6 +325,9 @@ void PairDeepMD::compute(int eflag, int vflag) {
         // interface the atomic virial computed by DeepMD
         // with the one used in centroid atoms
         if (cvflag_atom) {
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
           for (int ii = 0; ii < nall; ++ii) {
             // vatom[ii][0] += 1.0 * dvatom[9*ii+0];
             // vatom[ii][1] += 1.0 * dvatom[9*ii+4];
@@ -306,6 +363,7 @@ void PairDeepMD::compute(int eflag, int vflag) {
       vector<double> all_energy;
       vector<vector<double>> all_atom_energy;
       vector<vector<double>> all_atom_virial;
+      const double time_call = MPI_Wtime();
       if (!(eflag_atom || cvflag_atom)) {
         try {
           deep_pot_model_devi.compute(all_energy, all_force, all_virial, dcoord,
@@ -324,6 +382,7 @@ void PairDeepMD::compute(int eflag, int vflag) {
           error->one(FLERR, e.what());
         }
       }
+      time_model_call += MPI_Wtime() - time_call;
       // deep_pot_model_devi.compute_avg (dener, all_energy);
       // deep_pot_model_devi.compute_avg (dforce, all_force);
       // deep_pot_model_devi.compute_avg (dvirial, all_virial);
@@ -334,6 +393,9 @@ void PairDeepMD::compute(int eflag, int vflag) {
       dvirial = all_virial[0];
       if (eflag_atom) {
         deatom = all_atom_energy[0];
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
         for (int ii = 0; ii < nlocal; ++ii) {
           eatom[ii] += scale[1][1] * deatom[ii] * ener_unit_cvt_factor;
         }
@@ -343,6 +405,9 @@ void PairDeepMD::compute(int eflag, int vflag) {
       // with the one used in centroid atoms
       if (cvflag_atom) {
         dvatom = all_atom_virial[0];
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
         for (int ii = 0; ii < nall; ++ii) {
           // vatom[ii][0] += 1.0 * dvatom[9*ii+0];
           // vatom[ii][1] += 1.0 * dvatom[9*ii+4];
@@ -445,6 +510,16 @@ void PairDeepMD::compute(int eflag, int vflag) {
              << " " << setw(18) << all_f_max << " " << setw(18) << all_f_min
              << " " << setw(18) << all_f_avg;
         }
+        if (skip_devi_max > 0) {
+          MPI_Bcast(&all_f_max, 1, MPI_DOUBLE, 0, world);
+          if (all_f_max < skip_devi_threshold) {
+            skip_devi_from = ntimestep;
+            skip_devi_until = ntimestep + bigint(skip_devi_max) * out_freq;
+          }
+        }
+        if (!atomic_file.empty()) {
+          write_atomic_devi(std_f, nlocal);
+        }
         if (out_each == 1) {
           vector<double> std_f_all(atom->natoms);
           // Gather std_f and tags
@@ -493,20 +568,28 @@ void PairDeepMD::compute(int eflag, int vflag) {
     }
   } else {
     if (numb_models == 1) {
+      const double time_call = MPI_Wtime();
       try {
         deep_pot.compute(dener, dforce, dvirial, dcoord, dtype, dbox);
       } catch (deepmd_compat::deepmd_exception &e) {
         error->one(FLERR, e.what());
       }
+      time_model_call += MPI_Wtime() - time_call;
     } else {
       error->all(FLERR, "Serial version does not support model devi");
     }
   }
 
   // get force
-  for (int ii = 0; ii < nall; ++ii) {
-    for (int dd = 0; dd < 3; ++dd) {
-      f[ii][dd] += scale[1][1] * dforce[3 * ii + dd] * force_unit_cvt_factor;
+  if (!force_written && nall > 0) {
+    double *ff = f[0];
+    const double force_scale = scale[1][1];
+    const double force_cvt = force_unit_cvt_factor;
+#if defined(_OPENMP)
+#pragma omp parallel for simd num_threads(comm->nthreads)
+#endif
+    for (int ii = 0; ii < nall * 3; ++ii) {
+      ff[ii] += force_scale * dforce[ii] * force_cvt;
     }
   }
 
@@ -522,6 +605,51 @@ void PairDeepMD::compute(int eflag, int vflag) {
     virial[4] += 1.0 * dvirial[6] * scale[1][1] * ener_unit_cvt_factor;
     virial[5] += 1.0 * dvirial[7] * scale[1][1] * ener_unit_cvt_factor;
   }
+
+  time_model += time_model_call;
+  time_post += MPI_Wtime() - time_pre_end - time_model_call;
+  ++time_ncalls;
+}
+
+void PairDeepMD::write_atomic_devi(const vector<double> &std_f,
+                                   const int nlocal) {
+  // a frame is a header of the step, the number of atoms, and the number of
+  // records, followed by the tags and then the model deviations of the
+  // records; each rank writes its block of the tags and of the deviations
+  tagint *tag = atom->tag;
+  vector<int64_t> rec_tags;
+  vector<double> rec_devi;
+  rec_tags.reserve(nlocal);
+  rec_devi.reserve(nlocal);
+  for (int ii = 0; ii < nlocal; ++ii) {
+    double devi = std_f[ii] * force_unit_cvt_factor;
+    if (devi >= atomic_threshold) {
+      rec_tags.push_back(tag[ii]);
+      rec_devi.push_back(devi);
+    }
+  }
+  int64_t nrec = rec_tags.size(), rec_start = 0, nrec_all = 0;
+  MPI_Exscan(&nrec, &rec_start, 1, MPI_INT64_T, MPI_SUM, world);
+  if (comm->me == 0) {
+    rec_start = 0;
+  }
+  MPI_Allreduce(&nrec, &nrec_all, 1, MPI_INT64_T, MPI_SUM, world);
+  const MPI_Offset header_size = 3 * sizeof(int64_t);
+  if (comm->me == 0) {
+    int64_t header[3] = {update->ntimestep, atom->natoms, nrec_all};
+    MPI_File_write_at(atomic_fh, atomic_offset, header, 3, MPI_INT64_T,
+                      MPI_STATUS_IGNORE);
+  }
+  MPI_Offset tag_pos =
+      atomic_offset + header_size + rec_start * sizeof(int64_t);
+  MPI_Offset devi_pos = atomic_offset + header_size +
+                        nrec_all * sizeof(int64_t) + rec_start * sizeof(double);
+  MPI_File_write_at_all(atomic_fh, tag_pos, rec_tags.data(), nrec,
+                        MPI_INT64_T, MPI_STATUS_IGNORE);
+  MPI_File_write_at_all(atomic_fh, devi_pos, rec_devi.data(), nrec, MPI_DOUBLE,
+                        MPI_STATUS_IGNORE);
+  atomic_offset +=
+      header_size + nrec_all * (sizeof(int64_t) + sizeof(double));
 }
 
 static bool is_key(const string &input) {
@@ -534,8 +662,11 @@ static bool is_key(const string &input) {
   keys.push_back("aparam_from_compute");
   keys.push_back("ttm");
   keys.push_back("atomic");
+  keys.push_back("atomic_file");
+  keys.push_back("atomic_threshold");
   keys.push_back("relative");
   keys.push_back("relative_v");
+  keys.push_back("skip_devi");
   keys.push_back("virtual_len");
   keys.push_back("spin_norm");
 
@@ -564,9 +695,14 @@ void PairDeepMD::settings(int narg, char **arg) {
     models.push_back(arg[ii]);
   }
   numb_models = models.size();
+  int node_nranks = 1;
+  MPI_Comm node_comm;
+  const int node_rank = get_node_rank(&node_nranks, &node_comm);
+  bind_node_cores(node_rank, node_nranks, node_comm);
+  MPI_Comm_free(&node_comm);
   if (numb_models == 1) {
     try {
-      deep_pot.init(arg[0], get_node_rank(), get_file_content(arg[0]));
+      deep_pot.init(arg[0], node_rank, get_file_content(arg[0]));
     } catch (deepmd_compat::deepmd_exception &e) {
       error->one(FLERR, e.what());
     }
@@ -577,9 +713,10 @@ void PairDeepMD::settings(int narg, char **arg) {
     dim_aparam = deep_pot.dim_aparam();
   } else {
     try {
-      deep_pot.init(arg[0], get_node_rank(), get_file_content(arg[0]));
-      deep_pot_model_devi.init(models, get_node_rank(),
-                               get_file_content(models));
+      // broadcast all models at once and reuse the first one
+      std::vector<std::string> file_contents = get_file_content(models);
+      deep_pot.init(arg[0], node_rank, file_contents[0]);
+      deep_pot_model_devi.init(models, node_rank, file_contents);
     } catch (deepmd_compat::deepmd_exception &e) {
       error->one(FLERR, e.what());
     }
@@ -597,6 +734,7 @@ void PairDeepMD::settings(int narg, char **arg) {
 
   out_freq = 100;
   out_file = "model_devi.out";
+  atomic_file.clear();
   out_each = 0;
   out_rel = 0;
   eps = 0.;
@@ -687,6 +825,18 @@ void PairDeepMD::settings(int narg, char **arg) {
     } else if (string(arg[iarg]) == string("atomic")) {
       out_each = 1;
       iarg += 1;
+    } else if (string(arg[iarg]) == string("atomic_file")) {
+      if (iarg + 1 >= narg) {
+        error->all(FLERR, "Illegal atomic_file, not provided");
+      }
+      atomic_file = string(arg[iarg + 1]);
+      iarg += 2;
+    } else if (string(arg[iarg]) == string("atomic_threshold")) {
+      if (iarg + 1 >= narg) {
+        error->all(FLERR, "Illegal atomic_threshold, not provided");
+      }
+      atomic_threshold = atof(arg[iarg + 1]);
+      iarg += 2;
     } else if (string(arg[iarg]) == string("relative")) {
       out_rel = 1;
       eps = atof(arg[iarg + 1]) / ener_unit_cvt_factor;
@@ -695,6 +845,13 @@ void PairDeepMD::settings(int narg, char **arg) {
       out_rel_v = 1;
       eps_v = atof(arg[iarg + 1]) / ener_unit_cvt_factor;
       iarg += 2;
+    } else if (string(arg[iarg]) == string("skip_devi")) {
+      if (iarg + 2 >= narg) {
+        error->all(FLERR, "Illegal skip_devi, not provided");
+      }
+      skip_devi_threshold = atof(arg[iarg + 1]);
+      skip_devi_max = atoi(arg[iarg + 2]);
+      iarg += 3;
     } else if (string(arg[iarg]) == string("virtual_len")) {
       virtual_len.resize(numb_types_spin);
       for (int ii = 0; ii < numb_types_spin; ++ii) {
@@ -713,6 +870,9 @@ void PairDeepMD::settings(int narg, char **arg) {
   if (out_freq < 0) {
     error->all(FLERR, "Illegal out_freq, should be >= 0");
   }
+  if (skip_devi_max < 0) {
+    error->all(FLERR, "Illegal skip_devi, the number of steps should be >= 0");
+  }
   if ((int)do_ttm + (int)do_compute_aparam + (int)(aparam.size() > 0) > 1) {
     error->all(FLERR,
                "aparam, aparam_from_compute, and ttm should NOT be set "
@@ -724,6 +884,29 @@ void PairDeepMD::settings(int narg, char **arg) {
         "fparam and fparam_from_compute should NOT be set simultaneously");
   }
 
+  // a reissued pair_style reopens the file like out_file, or closes it if
+  // the keyword is dropped
+  if (atomic_file_opened) {
+    MPI_File_close(&atomic_fh);
+    atomic_file_opened = false;
+  }
+  if (!atomic_file.empty()) {
+    // the atomic model deviation is written to the binary file instead
+    out_each = 0;
+    if (numb_models > 1 && out_freq > 0) {
+      if (MPI_File_open(world, atomic_file.c_str(),
+                        MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                        &atomic_fh) != MPI_SUCCESS) {
+        error->all(FLERR, "Cannot open atomic_file " + atomic_file);
+      }
+      if (!is_restart) {
+        MPI_File_set_size(atomic_fh, 0);
+      }
+      MPI_File_get_size(atomic_fh, &atomic_offset);
+      atomic_file_opened = true;
+    }
+  }
+
   if (comm->me == 0) {
     if (numb_models > 1 && out_freq > 0) {
       if (!is_restart) {
@@ -888,6 +1071,15 @@ void PairDeepMD::coeff(int narg, char **arg) {
 
 /* ---------------------------------------------------------------------- */
 
+bool PairDeepMD::is_type_ignored(const int itype) const {
+  // the types out of the model, e.g. NULL in pair_coeff, are removed as
+  // virtual atoms
+  const int dtype = type_idx_map[itype];
+  return dtype < 0 || dtype >= deep_pot.numb_types();
+}
+
+/* ---------------------------------------------------------------------- */
+
 int PairDeepMD::pack_reverse_comm(int n, int first, double *buf) {
   int i, m, last;
 
@@ -49,13 +49,34 @@ class PairDeepMD : public PairDeepBaseModel {
   void compute(int, int) override;
   int pack_reverse_comm(int, int, double *) override;
   void unpack_reverse_comm(int, int *, double *) override;
+  // whether the atoms of the LAMMPS type itype (starting from 0) are removed
+  // before the model is called
+  bool is_type_ignored(const int itype) const;
 
  protected:
+  void write_atomic_devi(const std::vector<double> &std_f, const int nlocal);
+  // binary output of the atomic model deviation through MPI-IO
+  std::string atomic_file;
+  double atomic_threshold;
+  bool atomic_file_opened;
+  MPI_File atomic_fh;
+  MPI_Offset atomic_offset;
+  // skip the model deviation of out_freq steps while it stays small
+  double skip_devi_threshold;
+  int skip_devi_max;
+  bigint skip_devi_from;
+  bigint skip_devi_until;
   deepmd_compat::DeepPot deep_pot;
   deepmd_compat::DeepPotModelDevi deep_pot_model_devi;
 
  private:
   CommBrickDeepMD *commdata_;
+  // workspaces of compute, which only grow
+  std::vector<int> dtype_buff;
+  std::vector<double> dcoord_buff;
+  std::vector<double> dforce_buff;
+  std::vector<double> dvirial_buff;
+  std::vector<int> mapping_buff;
 };
 
 }  // namespace LAMMPS_NS
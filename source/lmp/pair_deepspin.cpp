@@ -133,6 +133,8 @@ void PairDeepSpin::compute(int eflag, int vflag) {
   // See
   // https://docs.lammps.org/Developer_updating.html#use-ev-init-to-initialize-variables-derived-from-eflag-and-vflag
   ev_init(eflag, vflag);
+  const double time_start = MPI_Wtime();
+  double time_model_call = 0.;
   if (vflag_atom) {
     error->all(FLERR,
                "6-element atomic virial is not supported. Use compute "
@@ -159,6 +161,9 @@ void PairDeepSpin::compute(int eflag, int vflag) {
   // spin initialize
   if (atom->sp_flag) {
     // get spin
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
     for (int ii = 0; ii < nall; ++ii) {
       for (int dd = 0; dd < 3; ++dd) {
         dspin[ii * 3 + dd] = sp[ii][dd] * sp[ii][3];  // get real spin vector
@@ -172,6 +177,9 @@ void PairDeepSpin::compute(int eflag, int vflag) {
   }
 
   vector<int> dtype(nall);
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
   for (int ii = 0; ii < nall; ++ii) {
     dtype[ii] = type_idx_map[type[ii] - 1];
   }
@@ -193,6 +201,9 @@ void PairDeepSpin::compute(int eflag, int vflag) {
   dbox[3] = domain->h[5] / dist_unit_cvt_factor;  // yx
 
   // get coord
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
   for (int ii = 0; ii < nall; ++ii) {
     for (int dd = 0; dd < 3; ++dd) {
       dcoord[ii * 3 + dd] =
@@ -219,16 +230,8 @@ void PairDeepSpin::compute(int eflag, int vflag) {
     make_fparam_from_compute(fparam);
   }
 
-  // int ago = numb_models > 1 ? 0 : neighbor->ago;
-  int ago = neighbor->ago;
-  if (numb_models > 1) {
-    if (multi_models_no_mod_devi &&
-        (out_freq > 0 && update->ntimestep % out_freq == 0)) {
-      ago = 0;
-    } else if (multi_models_mod_devi &&
-               (out_freq == 0 || update->ntimestep % out_freq != 0)) {
-      ago = 0;
-    }
+  if (neighbor->ago == 0) {
+    ++nlist_build;
   }
   // compute
   single_model = (numb_models == 1);
@@ -236,6 +239,10 @@ void PairDeepSpin::compute(int eflag, int vflag) {
       (numb_models > 1 && (out_freq == 0 || update->ntimestep % out_freq != 0));
   multi_models_mod_devi =
       (numb_models > 1 && (out_freq > 0 && update->ntimestep % out_freq == 0));
+  int ago = multi_models_mod_devi ? get_ago(multi_nlist_build)
+                                  : get_ago(single_nlist_build);
+  const double time_pre_end = MPI_Wtime();
+  time_pre += time_pre_end - time_start;
   if (do_ghost) {
     deepmd_compat::InputNlist lmp_list(
         list->inum, list->ilist, list->numneigh, list->firstneigh,
@@ -246,6 +253,7 @@ void PairDeepSpin::compute(int eflag, int vflag) {
     if (single_model || multi_models_no_mod_devi) {
       // cvflag_atom is the right flag for the cvatom matrix
       if (!(eflag_atom || cvflag_atom)) {
+        const double time_call = MPI_Wtime();
         try {
           deep_spin.compute(dener, dforce, dforce_mag, dvirial, dcoord, dspin,
                             dtype, dbox, nghost, lmp_list, ago, fparam,
@@ -253,11 +261,13 @@ void PairDeepSpin::compute(int eflag, int vflag) {
         } catch (deepmd_compat::deepmd_exception &e) {
           error->one(FLERR, e.what());
         }
+        time_model_call += MPI_Wtime() - time_call;
       }
       // do atomic energy and virial
       else {
         vector<double> deatom(nall * 1, 0);
         vector<double> dvatom(nall * 9, 0);
+        const double time_call = MPI_Wtime();
         try {
           deep_spin.compute(dener, dforce, dforce_mag, dvirial, deatom, dvatom,
                             dcoord, dspin, dtype, dbox, nghost, lmp_list, ago,
@@ -265,7 +275,11 @@ void PairDeepSpin::compute(int eflag, int vflag) {
         } catch (deepmd_compat::deepmd_exception &e) {
           error->one(FLERR, e.what());
         }
+        time_model_call += MPI_Wtime() - time_call;
         if (eflag_atom) {
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
           for (int ii = 0; ii < nlocal; ++ii) {
             eatom[ii] += scale[1][1] * deatom[ii] * ener_unit_cvt_factor;
           }
@@ -274,6 +288,9 @@ void PairDeepSpin::compute(int eflag, int vflag) {
         // interface the atomic virial computed by DeepMD
         // with the one used in centroid atoms
         if (cvflag_atom) {
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
           for (int ii = 0; ii < nall; ++ii) {
             // vatom[ii][0] += 1.0 * dvatom[9*ii+0];
             // vatom[ii][1] += 1.0 * dvatom[9*ii+4];
@@ -309,6 +326,7 @@ void PairDeepSpin::compute(int eflag, int vflag) {
       vector<double> all_energy;
       vector<vector<double>> all_atom_energy;
       vector<vector<double>> all_atom_virial;
+      const double time_call = MPI_Wtime();
       if (!(eflag_atom || cvflag_atom)) {
         try {
           deep_spin_model_devi.compute(all_energy, all_force, all_force_mag,
@@ -327,6 +345,7 @@ void PairDeepSpin::compute(int eflag, int vflag) {
           error->one(FLERR, e.what());
         }
       }
+      time_model_call += MPI_Wtime() - time_call;
       // deep_spin_model_devi.compute_avg (dener, all_energy);
       // deep_spin_model_devi.compute_avg (dforce, all_force);
       // deep_spin_model_devi.compute_avg (dvirial, all_virial);
@@ -338,6 +357,9 @@ void PairDeepSpin::compute(int eflag, int vflag) {
       dvirial = all_virial[0];
       if (eflag_atom) {
         deatom = all_atom_energy[0];
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
         for (int ii = 0; ii < nlocal; ++ii) {
           eatom[ii] += scale[1][1] * deatom[ii] * ener_unit_cvt_factor;
         }
@@ -347,6 +369,9 @@ void PairDeepSpin::compute(int eflag, int vflag) {
       // with the one used in centroid atoms
       if (cvflag_atom) {
         dvatom = all_atom_virial[0];
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
         for (int ii = 0; ii < nall; ++ii) {
           // vatom[ii][0] += 1.0 * dvatom[9*ii+0];
           // vatom[ii][1] += 1.0 * dvatom[9*ii+4];
@@ -517,12 +542,14 @@ void PairDeepSpin::compute(int eflag, int vflag) {
     }
   } else {
     if (numb_models == 1) {
+      const double time_call = MPI_Wtime();
       try {
         deep_spin.compute(dener, dforce, dforce_mag, dvirial, dcoord, dspin,
                           dtype, dbox);
       } catch (deepmd_compat::deepmd_exception &e) {
         error->one(FLERR, e.what());
       }
+      time_model_call += MPI_Wtime() - time_call;
     } else {
       error->all(FLERR, "Serial version does not support model devi");
     }
@@ -531,6 +558,9 @@ void PairDeepSpin::compute(int eflag, int vflag) {
   // get force
   // unit_factor = hbar / spin_norm;
   const double hbar = 6.5821191e-04;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(comm->nthreads)
+#endif
   for (int ii = 0; ii < nall; ++ii) {
     for (int dd = 0; dd < 3; ++dd) {
       f[ii][dd] += scale[1][1] * dforce[3 * ii + dd] * force_unit_cvt_factor;
@@ -555,6 +585,10 @@ void PairDeepSpin::compute(int eflag, int vflag) {
     virial[4] += 1.0 * dvirial[6] * scale[1][1] * ener_unit_cvt_factor;
     virial[5] += 1.0 * dvirial[7] * scale[1][1] * ener_unit_cvt_factor;
   }
+
+  time_model += time_model_call;
+  time_post += MPI_Wtime() - time_pre_end - time_model_call;
+  ++time_ncalls;
 }
 
 static bool is_key(const string &input) {
@@ -597,9 +631,14 @@ void PairDeepSpin::settings(int narg, char **arg) {
     models.push_back(arg[ii]);
   }
   numb_models = models.size();
+  int node_nranks = 1;
+  MPI_Comm node_comm;
+  const int node_rank = get_node_rank(&node_nranks, &node_comm);
+  bind_node_cores(node_rank, node_nranks, node_comm);
+  MPI_Comm_free(&node_comm);
   if (numb_models == 1) {
     try {
-      deep_spin.init(arg[0], get_node_rank(), get_file_content(arg[0]));
+      deep_spin.init(arg[0], node_rank, get_file_content(arg[0]));
     } catch (deepmd_compat::deepmd_exception &e) {
       error->one(FLERR, e.what());
     }
@@ -610,9 +649,10 @@ void PairDeepSpin::settings(int narg, char **arg) {
     dim_aparam = deep_spin.dim_aparam();
   } else {
     try {
-      deep_spin.init(arg[0], get_node_rank(), get_file_content(arg[0]));
-      deep_spin_model_devi.init(models, get_node_rank(),
-                                get_file_content(models));
+      // broadcast all models at once and reuse the first one
+      std::vector<std::string> file_contents = get_file_content(models);
+      deep_spin.init(arg[0], node_rank, file_contents[0]);
+      deep_spin_model_devi.init(models, node_rank, file_contents);
     } catch (deepmd_compat::deepmd_exception &e) {
       error->one(FLERR, e.what());
     }
@@ -6,6 +6,7 @@
 #include "atom.h"
 #include "domain.h"
 #include "error.h"
+#include "fix_dplr.h"
 #include "force.h"
 #if LAMMPS_VERSION_NUMBER >= 20221222
 #include "grid3d.h"
@@ -44,6 +45,7 @@ PPPMDPLR::PPPMDPLR(LAMMPS *lmp)
 #endif
 {
   triclinic_support = 1;
+  fix_dplr = nullptr;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -92,6 +94,12 @@ void PPPMDPLR::compute(int eflag, int vflag) {
     return;
   }
 
+  // the Wannier centroids of a pipelined fix dplr should be in place
+
+  if (fix_dplr) {
+    fix_dplr->wait_dipole();
+  }
+
   // convert atoms from box to lambda coords
 
   if (triclinic == 0) {
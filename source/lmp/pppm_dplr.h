@@ -17,6 +17,8 @@ KSpaceStyle(pppm/dplr, PPPMDPLR)
 
 namespace LAMMPS_NS {
 
+class FixDPLR;
+
 class PPPMDPLR : public PPPM {
  public:
 #if LAMMPS_VERSION_NUMBER < 20181109
@@ -29,6 +31,7 @@ class PPPMDPLR : public PPPM {
   void init() override;
   const std::vector<double> &get_fele() const { return fele; };
   std::vector<double> &get_fele() { return fele; }
+  void set_fix_dplr(FixDPLR *fix) { fix_dplr = fix; }
 
  protected:
   void compute(int, int) override;
@@ -37,6 +40,7 @@ class PPPMDPLR : public PPPM {
 
  private:
   std::vector<double> fele;
+  FixDPLR *fix_dplr;
 };
 
 }  // namespace LAMMPS_NS
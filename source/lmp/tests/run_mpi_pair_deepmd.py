@@ -58,8 +58,10 @@ lammps.pair_style(
 )
 lammps.pair_coeff("* *")
 lammps.run(0)
+# gather_atoms is collective, and the forces are sorted by atom IDs
+forces = np.array(lammps.lmp.gather_atoms("f", 1, 3))
 if rank == 0:
     pe = lammps.eval("pe")
-    arr = [pe]
+    arr = [pe, *forces]
     np.savetxt(output, np.array(arr))
 MPI.Finalize()
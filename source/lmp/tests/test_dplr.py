@@ -420,6 +420,35 @@ def test_pair_deepmd_lr(lammps) -> None:
     lammps.run(1)
 
 
+def _run_dplr_pipeline(pipeline: str) -> tuple[float, np.ndarray]:
+    lmp = _lammps(data_file=data_file)
+    lmp.pair_style(f"deepmd {pb_file.resolve()}")
+    lmp.pair_coeff("* *")
+    lmp.bond_style("zero")
+    lmp.bond_coeff("*")
+    lmp.special_bonds("lj/coul 1 1 1 angle no")
+    lmp.kspace_style("pppm/dplr 1e-5")
+    lmp.kspace_modify(f"gewald {beta:.2f} diff ik mesh {mesh:d} {mesh:d} {mesh:d}")
+    lmp.fix(
+        f"0 all dplr model {pb_file.resolve()} type_associate 1 3 bond_type 1 "
+        f"pipeline {pipeline}"
+    )
+    lmp.fix_modify("0 virial yes")
+    lmp.run(2)
+    pe = lmp.eval("pe")
+    forces = np.array([lmp.atoms[ii].force for ii in range(8)])
+    ids = np.array([lmp.atoms[ii].id for ii in range(8)])
+    lmp.close()
+    return pe, forces[np.argsort(ids)]
+
+
+def test_pair_deepmd_lr_pipeline() -> None:
+    pe, forces = _run_dplr_pipeline("no")
+    pe_pipeline, forces_pipeline = _run_dplr_pipeline("yes")
+    assert pe_pipeline == pytest.approx(pe)
+    assert forces_pipeline == pytest.approx(forces)
+
+
 def test_pair_deepmd_lr_run0(lammps2) -> None:
     lammps2.pair_style(f"deepmd {pb_file.resolve()}")
     lammps2.pair_coeff("* *")
@@ -318,6 +318,22 @@ def test_pair_deepmd(lammps) -> None:
     lammps.run(1)
 
 
+def test_pair_deepmd_pre_force_fix(lammps) -> None:
+    lammps.pair_style(f"deepmd {pb_file.resolve()}")
+    lammps.pair_coeff("* *")
+    # a fix invoked before the pair style, after which the pair style has to
+    # add its forces to atom->f instead of writing them
+    lammps.variable("one equal 1.0")
+    lammps.fix("adapt all adapt 1 pair deepmd scale * * v_one")
+    lammps.run(0)
+    assert lammps.eval("pe") == pytest.approx(expected_e)
+    for ii in range(6):
+        assert lammps.atoms[ii].force == pytest.approx(
+            expected_f[lammps.atoms[ii].id - 1]
+        )
+    lammps.run(1)
+
+
 def test_pair_deepmd_virial(lammps) -> None:
     lammps.pair_style(f"deepmd {pb_file.resolve()}")
     lammps.pair_coeff("* *")
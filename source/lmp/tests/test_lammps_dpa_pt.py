@@ -719,3 +719,48 @@ def test_pair_deepmd_mpi(balance_args: list) -> None:
     assert md[1] == pytest.approx(np.max(expected_md_v))
     assert md[2] == pytest.approx(np.min(expected_md_v))
     assert md[3] == pytest.approx(np.sqrt(np.mean(np.square(expected_md_v))))
+
+
+@pytest.mark.skipif(
+    shutil.which("mpirun") is None, reason="MPI is not installed on this system"
+)
+@pytest.mark.skipif(
+    importlib.util.find_spec("mpi4py") is None, reason="mpi4py is not installed"
+)
+@pytest.mark.parametrize(
+    ("precision", "eps"),
+    [
+        ("float32", np.finfo(np.float32).eps),
+        ("float16", np.finfo(np.float16).eps),
+        # the machine epsilon of bfloat16, which is not a numpy type
+        ("bfloat16", 2.0**-7),
+    ],
+)
+def test_pair_deepmd_mpi_ghost_exchange_precision(precision: str, eps: float) -> None:
+    with tempfile.NamedTemporaryFile() as f:
+        sp.check_call(
+            [
+                "mpirun",
+                "-n",
+                "2",
+                sys.executable,
+                Path(__file__).parent / "run_mpi_pair_deepmd.py",
+                data_file,
+                pb_file,
+                pb_file2,
+                md_file,
+                f.name,
+                "--balance",
+            ],
+            env={**os.environ, "DP_GHOST_EXCHANGE_PRECISION": precision},
+        )
+        arr = np.loadtxt(f.name, ndmin=1)
+    pe = arr[0]
+    forces = arr[1:].reshape(-1, 3)
+    # the features are rounded to the relative precision eps, and the rounding
+    # error is amplified by the layers of the model
+    amplification = 100.0
+    tol_f = amplification * eps * np.max(np.abs(expected_f))
+    tol_e = amplification * eps * np.sum(np.abs(expected_ae))
+    assert pe == pytest.approx(expected_e, abs=tol_e)
+    assert np.max(np.abs(forces - expected_f)) < tol_f
@@ -8,26 +8,63 @@
 #endif
 #include <torch/torch.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #if defined(GOOGLE_CUDA) || defined(TENSORFLOW_USE_ROCM)
 #include "device.h"
 #endif
 
 #ifdef USE_MPI
-template <typename T>
-static MPI_Datatype get_mpi_type();
-
-template <>
-MPI_Datatype get_mpi_type<float>() {
-  return MPI_FLOAT;
+static MPI_Datatype get_mpi_type(const torch::ScalarType& dtype) {
+  if (dtype == torch::kDouble) {
+    return MPI_DOUBLE;
+  } else if (dtype == torch::kFloat) {
+    return MPI_FLOAT;
+  }
+  // MPI has no 16-bit floating point type; the bits are sent as they are
+  return MPI_UINT16_T;
 }
+#endif
 
-template <>
-MPI_Datatype get_mpi_type<double>() {
-  return MPI_DOUBLE;
+/**
+ * @brief Get the type of the exchanged features.
+ * @details The features are exchanged in the type set by the environment
+ * variable DP_GHOST_EXCHANGE_PRECISION (float32, float16, or bfloat16) if it
+ * is lower than the type of the features, and are converted back on receive.
+ * The swaps of a rank with itself are kept in the type of the features.
+ **/
+static torch::ScalarType get_comm_dtype(const torch::ScalarType& dtype) {
+  // the variable is read once instead of at each exchange; double, which is
+  // never lowered, stands for an unset variable
+  static const torch::ScalarType comm_dtype = []() {
+    const char* env_precision = std::getenv("DP_GHOST_EXCHANGE_PRECISION");
+    if (env_precision == nullptr) {
+      return torch::kDouble;
+    }
+    std::string precision(env_precision);
+    if (precision == "float32") {
+      return torch::kFloat;
+    } else if (precision == "float16") {
+      return torch::kHalf;
+    } else if (precision == "bfloat16") {
+      return torch::kBFloat16;
+    }
+    throw std::runtime_error(
+        "DP_GHOST_EXCHANGE_PRECISION should be float32, float16, or bfloat16, "
+        "but got " +
+        precision);
+  }();
+  if (c10::elementSize(comm_dtype) >= c10::elementSize(dtype)) {
+    return dtype;
+  }
+  return comm_dtype;
 }
-#endif
 
 class Border : public torch::autograd::Function<Border> {
  public:
@@ -81,7 +118,8 @@ class Border : public torch::autograd::Function<Border> {
     int nlocal = nlocal_tensor.item<int>();
     int nghost = nghost_tensor.item<int>();
     int ntotal = nlocal + nghost;
-    torch::Tensor recv_g1_tensor = g1;
+    bool on_device = false;
+    bool staging = false;
 
 #ifdef USE_MPI
     int mpi_init = 0;
@@ -95,8 +133,6 @@ class Border : public torch::autograd::Function<Border> {
       MPI_Comm_rank(world, &me);
       MPI_Comm_size(world, &world_size);
     }
-    MPI_Datatype mpi_type = get_mpi_type<FPTYPE>();
-    MPI_Request request;
 #if defined(GOOGLE_CUDA) || defined(TENSORFLOW_USE_ROCM)
     if (world_size >= 1) {
       int version, subversion;
@@ -110,73 +146,121 @@ class Border : public torch::autograd::Function<Border> {
       } else {
         cuda_aware = 0;
       }
-      if (cuda_aware == 0) {
-        recv_g1_tensor = torch::empty_like(g1).to(torch::kCPU);
-        recv_g1_tensor.copy_(g1);
-      }
     }
+    // only the packed rows are staged through the host
+    staging = cuda_aware == 0 && g1.is_cuda();
 #endif
-#endif
-    FPTYPE* recv_g1 = recv_g1_tensor.data_ptr<FPTYPE>() + nlocal * tensor_size;
-    auto int32_options = torch::TensorOptions().dtype(torch::kInt32);
-    for (int iswap = 0; iswap < nswap; ++iswap) {
-      int nrecv = recvnum[iswap];
-      int nsend = sendnum[iswap];
-      torch::Tensor isendlist;
-      torch::Tensor send_g1_tensor;
-      FPTYPE* send_g1;
-      if (nsend != 0) {
-        isendlist = torch::from_blob(sendlist[iswap], {nsend}, int32_options)
-                        .to(recv_g1_tensor.device());
-        send_g1_tensor = recv_g1_tensor.index_select(0, isendlist);
-        send_g1 = send_g1_tensor.data_ptr<FPTYPE>();
-      }
-#ifdef USE_MPI
-      if (sendproc[iswap] != me) {
-        if (nrecv) {
-          MPI_Irecv(recv_g1, nrecv * tensor_size, mpi_type, recvproc[iswap], 0,
-                    world, &request);
-        }
-        if (nsend) {
-          MPI_Send(send_g1, nsend * tensor_size, mpi_type, sendproc[iswap], 0,
-                   world);
-        }
-        if (nrecv) {
-          MPI_Wait(&request, MPI_STATUS_IGNORE);
-        }
-      } else {
 #endif
 #if defined(GOOGLE_CUDA) || defined(TENSORFLOW_USE_ROCM)
+    on_device = g1.is_cuda() && !staging;
+#endif
+    torch::ScalarType comm_dtype = g1.scalar_type();
 #ifdef USE_MPI
-        if (cuda_aware == 0) {
-          memcpy(recv_g1, send_g1,
-                 (unsigned long)nsend * tensor_size * sizeof(FPTYPE));
+    // the precision is only lowered for the exchange between ranks
+    if (world_size > 1) {
+      comm_dtype = get_comm_dtype(comm_dtype);
+    }
+#endif
+    bool convert = comm_dtype != g1.scalar_type();
+    std::vector<int> send_offset, recv_offset;
+    std::vector<int> stages = split_stages(sendlist, sendnum, recvnum, nswap,
+                                           nlocal, send_offset, recv_offset);
+    // the send lists of all swaps are moved to the device at once
+    std::vector<int> sendlist_all(send_offset[nswap]);
+    for (int iswap = 0; iswap < nswap; ++iswap) {
+      std::copy(sendlist[iswap], sendlist[iswap] + sendnum[iswap],
+                sendlist_all.begin() + send_offset[iswap]);
+    }
+    auto int32_options = torch::TensorOptions().dtype(torch::kInt32);
+    torch::Tensor sendlist_all_tensor;
+    if (send_offset[nswap] > 0) {
+      sendlist_all_tensor =
+          torch::from_blob(sendlist_all.data(), {send_offset[nswap]},
+                           int32_options)
+              .to(g1.device());
+    }
+    auto comm_options = g1.options().dtype(comm_dtype);
+    torch::Tensor send_g1_tensor =
+        torch::empty({send_offset[nswap], tensor_size}, comm_options);
+    // the received rows are converted before they are written to g1
+    torch::Tensor recv_g1_tensor;
+    if (convert && !staging) {
+      recv_g1_tensor =
+          torch::empty({recv_offset[nswap], tensor_size}, comm_options);
+    }
+    torch::Tensor send_host_tensor, recv_host_tensor;
+    if (staging) {
+      auto host_options =
+          torch::TensorOptions().dtype(comm_dtype).pinned_memory(true);
+      send_host_tensor =
+          torch::empty({send_offset[nswap], tensor_size}, host_options);
+      recv_host_tensor =
+          torch::empty({recv_offset[nswap], tensor_size}, host_options);
+    }
+
+    int nstage = stages.size() - 1;
+    for (int istage = 0; istage < nstage; ++istage) {
+      int first = stages[istage];
+      int last = stages[istage + 1];
+      int send_begin = send_offset[first];
+      int nsend_stage = send_offset[last] - send_begin;
+      int recv_begin = recv_offset[first];
+      int nrecv_stage = recv_offset[last] - recv_begin;
+      // pack all swaps of the stage in one kernel
+      if (nsend_stage) {
+        torch::Tensor send_stage =
+            send_g1_tensor.narrow(0, send_begin, nsend_stage);
+        torch::Tensor send_index =
+            sendlist_all_tensor.narrow(0, send_begin, nsend_stage);
+        if (convert) {
+          send_stage.copy_(g1.index_select(0, send_index));
         } else {
-          gpuMemcpy(recv_g1, send_g1,
-                    (unsigned long)nsend * tensor_size * sizeof(FPTYPE),
-                    gpuMemcpyDeviceToDevice);
+          torch::index_select_out(send_stage, g1, 0, send_index);
         }
-#else
-        gpuMemcpy(recv_g1, send_g1,
-                  (unsigned long)nsend * tensor_size * sizeof(FPTYPE),
-                  gpuMemcpyDeviceToDevice);
+        if (staging) {
+          send_host_tensor.narrow(0, send_begin, nsend_stage)
+              .copy_(send_stage);
+        }
+      }
+      void* send_g1 =
+          staging ? send_host_tensor.data_ptr() : send_g1_tensor.data_ptr();
+      void* recv_g1 = staging   ? recv_host_tensor.data_ptr()
+                      : convert ? recv_g1_tensor.data_ptr()
+                                : static_cast<void*>(g1.data_ptr<FPTYPE>() +
+                                                     nlocal * tensor_size);
+#if defined(GOOGLE_CUDA) || defined(TENSORFLOW_USE_ROCM)
+      if (on_device) {
+        // MPI reads the buffer after the packing kernel is done
+        gpuDeviceSynchronize();
+      }
 #endif
+#ifdef USE_MPI
+      exchange_stage(send_g1, recv_g1, first, last, sendproc, recvproc,
+                     sendnum, recvnum, send_offset, recv_offset, tensor_size,
+                     comm_dtype, on_device, me, world);
 #else
-      memcpy(recv_g1, send_g1,
-             (unsigned long)nsend * tensor_size * sizeof(FPTYPE));
+      exchange_stage(send_g1, recv_g1, first, last, sendproc, recvproc,
+                     sendnum, recvnum, send_offset, recv_offset, tensor_size,
+                     comm_dtype, on_device);
 #endif
+      if ((staging || convert) && nrecv_stage) {
+        torch::Tensor& recv_tensor =
+            staging ? recv_host_tensor : recv_g1_tensor;
+        g1.narrow(0, nlocal + recv_begin, nrecv_stage)
+            .copy_(recv_tensor.narrow(0, recv_begin, nrecv_stage));
+      }
 #ifdef USE_MPI
+      // the swaps with the rank itself are copied again in the full precision
+      for (int iswap = first; convert && iswap < last; ++iswap) {
+        if (sendproc[iswap] == me && recvnum[iswap]) {
+          g1.narrow(0, nlocal + recv_offset[iswap], recvnum[iswap])
+              .copy_(g1.index_select(
+                  0, sendlist_all_tensor.narrow(0, send_offset[iswap],
+                                                sendnum[iswap])));
+        }
       }
 #endif
-      recv_g1 += nrecv * tensor_size;
     }
-#ifdef USE_MPI
-#if defined(GOOGLE_CUDA) || defined(TENSORFLOW_USE_ROCM)
-    if (cuda_aware == 0) {
-      g1.copy_(recv_g1_tensor);
-    }
-#endif
-#endif
     return {g1};
   }
   static torch::autograd::variable_list backward(
@@ -208,6 +292,8 @@ class Border : public torch::autograd::Function<Border> {
     torch::Tensor nghost_tensor = saved_variables[7];
 
     torch::Tensor d_local_g1_tensor = grad_output[0].contiguous();
+    bool on_device = false;
+    bool staging = false;
 #ifdef USE_MPI
     int mpi_init = 0;
     MPI_Initialized(&mpi_init);
@@ -220,8 +306,6 @@ class Border : public torch::autograd::Function<Border> {
       MPI_Comm_rank(world, &me);
       MPI_Comm_size(world, &world_size);
     }
-    MPI_Datatype mpi_type = get_mpi_type<FPTYPE>();
-    MPI_Request request;
 #if defined(GOOGLE_CUDA) || defined(TENSORFLOW_USE_ROCM)
     if (world_size >= 1) {
       int version, subversion;
@@ -235,13 +319,21 @@ class Border : public torch::autograd::Function<Border> {
       } else {
         cuda_aware = 0;
       }
-      if (cuda_aware == 0) {
-        d_local_g1_tensor = torch::empty_like(grad_output[0]).to(torch::kCPU);
-        d_local_g1_tensor.copy_(grad_output[0]);
-      }
     }
+    // only the exchanged rows are staged through the host
+    staging = cuda_aware == 0 && d_local_g1_tensor.is_cuda();
+#endif
 #endif
+#if defined(GOOGLE_CUDA) || defined(TENSORFLOW_USE_ROCM)
+    on_device = d_local_g1_tensor.is_cuda() && !staging;
+#endif
+    torch::ScalarType comm_dtype = d_local_g1_tensor.scalar_type();
+#ifdef USE_MPI
+    if (world_size > 1) {
+      comm_dtype = get_comm_dtype(comm_dtype);
+    }
 #endif
+    bool convert = comm_dtype != d_local_g1_tensor.scalar_type();
     int** recvlist = reinterpret_cast<int**>(sendlist_tensor.data_ptr());
     // swap send and recv here
     int* recvproc = sendproc_tensor.data_ptr<int>();
@@ -249,100 +341,226 @@ class Border : public torch::autograd::Function<Border> {
     int* recvnum = sendnum_tensor.data_ptr<int>();
     int* sendnum = recvnum_tensor.data_ptr<int>();
 
-    FPTYPE* local_g1 = d_local_g1_tensor.data_ptr<FPTYPE>();
     int tensor_size = d_local_g1_tensor.size(1);
     int nswap = sendproc_tensor.size(0);
 
     int nlocal = nlocal_tensor.item<int>();
     int nghost = nghost_tensor.item<int>();
     int ntotal = nlocal + nghost;
-    torch::Tensor send_g1_tensor;
-    torch::Tensor recv_g1_tensor;
-    FPTYPE* recv_g1;
-    FPTYPE* send_g1;
-    if (nswap != 0) {
-      send_g1_tensor = d_local_g1_tensor;
-      int max_recvnum = sendnum_tensor.max().item<int>();
-      auto options = torch::TensorOptions()
-                         .dtype(d_local_g1_tensor.dtype())
-                         .device(d_local_g1_tensor.device());
-      recv_g1_tensor = torch::empty({max_recvnum, tensor_size}, options);
-      recv_g1 = recv_g1_tensor.data_ptr<FPTYPE>();
-      send_g1 = send_g1_tensor.data_ptr<FPTYPE>() + ntotal * tensor_size;
+    // the stages of the forward pass are walked in the reverse order; the
+    // gradient of the ghost atoms sent by a stage is complete once the later
+    // stages have been added
+    std::vector<int> recv_offset, send_offset;
+    std::vector<int> stages = split_stages(recvlist, recvnum, sendnum, nswap,
+                                           nlocal, recv_offset, send_offset);
+    std::vector<int> recvlist_all(recv_offset[nswap]);
+    for (int iswap = 0; iswap < nswap; ++iswap) {
+      std::copy(recvlist[iswap], recvlist[iswap] + recvnum[iswap],
+                recvlist_all.begin() + recv_offset[iswap]);
     }
-
-    int end = ntotal;
     auto int32_options = torch::TensorOptions().dtype(torch::kInt32);
-    for (int iswap = nswap - 1; iswap >= 0; --iswap) {
-      int nrecv = recvnum[iswap];
-      int nsend = sendnum[iswap];
+    torch::Tensor recvlist_all_tensor;
+    if (recv_offset[nswap] > 0) {
+      recvlist_all_tensor =
+          torch::from_blob(recvlist_all.data(), {recv_offset[nswap]},
+                           int32_options)
+              .to(d_local_g1_tensor.device());
+    }
+    torch::Tensor recv_g1_tensor = torch::empty(
+        {recv_offset[nswap], tensor_size}, d_local_g1_tensor.options());
+    // the gradient is converted before it is sent and after it is received
+    torch::Tensor send_comm_tensor, recv_comm_tensor;
+    if (convert && !staging) {
+      auto comm_options = d_local_g1_tensor.options().dtype(comm_dtype);
+      send_comm_tensor =
+          torch::empty({send_offset[nswap], tensor_size}, comm_options);
+      recv_comm_tensor =
+          torch::empty({recv_offset[nswap], tensor_size}, comm_options);
+    }
+    torch::Tensor send_host_tensor, recv_host_tensor;
+    if (staging) {
+      auto host_options =
+          torch::TensorOptions().dtype(comm_dtype).pinned_memory(true);
+      send_host_tensor =
+          torch::empty({send_offset[nswap], tensor_size}, host_options);
+      recv_host_tensor =
+          torch::empty({recv_offset[nswap], tensor_size}, host_options);
+    }
 
-      torch::Tensor irecvlist;
-      if (nrecv) {
-        irecvlist = torch::from_blob(recvlist[iswap], {nrecv}, int32_options)
-                        .to(d_local_g1_tensor.device());
+    int nstage = stages.size() - 1;
+    for (int istage = nstage - 1; istage >= 0; --istage) {
+      int first = stages[istage];
+      int last = stages[istage + 1];
+      int send_begin = send_offset[first];
+      int nsend_stage = send_offset[last] - send_begin;
+      int recv_begin = recv_offset[first];
+      int nrecv_stage = recv_offset[last] - recv_begin;
+      if ((staging || convert) && nsend_stage) {
+        torch::Tensor& send_tensor =
+            staging ? send_host_tensor : send_comm_tensor;
+        send_tensor.narrow(0, send_begin, nsend_stage)
+            .copy_(d_local_g1_tensor.narrow(0, nlocal + send_begin,
+                                            nsend_stage));
       }
-      if (nsend) {
-        send_g1 -= nsend * tensor_size;
+      void* send_g1 =
+          staging   ? send_host_tensor.data_ptr()
+          : convert ? send_comm_tensor.data_ptr()
+                    : static_cast<void*>(d_local_g1_tensor.data_ptr<FPTYPE>() +
+                                         nlocal * tensor_size);
+      void* recv_g1 = staging   ? recv_host_tensor.data_ptr()
+                      : convert ? recv_comm_tensor.data_ptr()
+                                : recv_g1_tensor.data_ptr();
+#if defined(GOOGLE_CUDA) || defined(TENSORFLOW_USE_ROCM)
+      if (on_device) {
+        // MPI reads the gradient after the later stages are added
+        gpuDeviceSynchronize();
       }
-#ifdef USE_MPI
-      if (sendproc[iswap] != me) {
-        if (nrecv) {
-          MPI_Irecv(recv_g1, nrecv * tensor_size, mpi_type, recvproc[iswap], 0,
-                    world, &request);
-        }
-        if (nsend) {
-          MPI_Send(send_g1, nsend * tensor_size, mpi_type, sendproc[iswap], 0,
-                   world);
-        }
-        if (nrecv) {
-          MPI_Wait(&request, MPI_STATUS_IGNORE);
-        }
-      } else {
 #endif
-        if (nrecv) {
-#if defined(GOOGLE_CUDA) || defined(TENSORFLOW_USE_ROCM)
 #ifdef USE_MPI
-          if (cuda_aware == 0) {
-            memcpy(recv_g1, send_g1,
-                   (unsigned long)nrecv * tensor_size * sizeof(FPTYPE));
-          } else {
-            gpuMemcpy(recv_g1, send_g1,
-                      (unsigned long)nrecv * tensor_size * sizeof(FPTYPE),
-                      gpuMemcpyDeviceToDevice);
-          }
-#else
-          gpuMemcpy(recv_g1, send_g1,
-                    (unsigned long)nrecv * tensor_size * sizeof(FPTYPE),
-                    gpuMemcpyDeviceToDevice);
-#endif
+      exchange_stage(send_g1, recv_g1, first, last, sendproc, recvproc,
+                     sendnum, recvnum, send_offset, recv_offset, tensor_size,
+                     comm_dtype, on_device, me, world);
 #else
-        memcpy(recv_g1, send_g1,
-               (unsigned long)nrecv * tensor_size * sizeof(FPTYPE));
+      exchange_stage(send_g1, recv_g1, first, last, sendproc, recvproc,
+                     sendnum, recvnum, send_offset, recv_offset, tensor_size,
+                     comm_dtype, on_device);
 #endif
+      if (nrecv_stage) {
+        if (staging || convert) {
+          torch::Tensor& recv_tensor =
+              staging ? recv_host_tensor : recv_comm_tensor;
+          recv_g1_tensor.narrow(0, recv_begin, nrecv_stage)
+              .copy_(recv_tensor.narrow(0, recv_begin, nrecv_stage));
         }
 #ifdef USE_MPI
-      }
+        // the swaps with the rank itself are copied again in the full
+        // precision
+        for (int iswap = first; convert && iswap < last; ++iswap) {
+          if (sendproc[iswap] == me && recvnum[iswap]) {
+            recv_g1_tensor.narrow(0, recv_offset[iswap], recvnum[iswap])
+                .copy_(d_local_g1_tensor.narrow(
+                    0, nlocal + send_offset[iswap], sendnum[iswap]));
+          }
+        }
 #endif
-      if (nrecv) {
-        d_local_g1_tensor.index_add_(0, irecvlist,
-                                     recv_g1_tensor.slice(0, 0, nrecv));
+        // add all swaps of the stage in one kernel
+        d_local_g1_tensor.index_add_(
+            0, recvlist_all_tensor.narrow(0, recv_begin, nrecv_stage),
+            recv_g1_tensor.narrow(0, recv_begin, nrecv_stage));
       }
     }
 #if defined(GOOGLE_CUDA) || defined(TENSORFLOW_USE_ROCM)
     gpuDeviceSynchronize();
 #endif
+
+    return {torch::Tensor(),   torch::Tensor(), torch::Tensor(),
+            torch::Tensor(),   torch::Tensor(), d_local_g1_tensor,
+            torch::Tensor(),   torch::Tensor(), torch::Tensor(),
+            torch::Tensor()};
+  }
+  /**
+   * @brief Split the swaps into stages of consecutive swaps that are
+   * exchanged together.
+   * @details A swap joins the stage unless it sends a ghost atom received by
+   * the stage, so that the swaps in the opposite directions of a dimension
+   * are in flight together, while the swaps of the next dimension, which
+   * forward the ghost atoms, wait for them.
+   * @param[out] send_offset The offsets of the sent atoms of the swaps.
+   * @param[out] recv_offset The offsets of the received atoms of the swaps,
+   * relative to the first ghost atom.
+   * @return The first swap of each stage, followed by the number of swaps.
+   **/
+  static std::vector<int> split_stages(int** sendlist,
+                                       const int* sendnum,
+                                       const int* recvnum,
+                                       const int nswap,
+                                       const int nlocal,
+                                       std::vector<int>& send_offset,
+                                       std::vector<int>& recv_offset) {
+    send_offset.assign(nswap + 1, 0);
+    recv_offset.assign(nswap + 1, 0);
+    for (int iswap = 0; iswap < nswap; ++iswap) {
+      send_offset[iswap + 1] = send_offset[iswap] + sendnum[iswap];
+      recv_offset[iswap + 1] = recv_offset[iswap] + recvnum[iswap];
+    }
+    std::vector<int> stages;
+    for (int iswap = 0; iswap < nswap; ++iswap) {
+      int max_send = -1;
+      for (int ii = 0; ii < sendnum[iswap]; ++ii) {
+        max_send = std::max(max_send, sendlist[iswap][ii]);
+      }
+      if (stages.empty() || max_send >= nlocal + recv_offset[stages.back()]) {
+        stages.push_back(iswap);
+      }
+    }
+    stages.push_back(nswap);
+    return stages;
+  }
+  /**
+   * @brief Exchange the swaps [first, last) of a stage, where the
+   * non-blocking sends and receives of all swaps are posted before waiting.
+   **/
+  static void exchange_stage(void* send_g1,
+                             void* recv_g1,
+                             const int first,
+                             const int last,
+                             const int* sendproc,
+                             const int* recvproc,
+                             const int* sendnum,
+                             const int* recvnum,
+                             const std::vector<int>& send_offset,
+                             const std::vector<int>& recv_offset,
+                             const int tensor_size,
+                             const torch::ScalarType& comm_dtype,
+                             const bool on_device
+#ifdef USE_MPI
+                             ,
+                             const int me,
+                             MPI_Comm world
+#endif
+  ) {
+    const size_t row_size = c10::elementSize(comm_dtype) * tensor_size;
+#ifdef USE_MPI
+    MPI_Datatype mpi_type = get_mpi_type(comm_dtype);
+    std::vector<MPI_Request> requests;
+#endif
+    for (int iswap = first; iswap < last; ++iswap) {
+      int nrecv = recvnum[iswap];
+      int nsend = sendnum[iswap];
+      char* send_buff =
+          static_cast<char*>(send_g1) + send_offset[iswap] * row_size;
+      char* recv_buff =
+          static_cast<char*>(recv_g1) + recv_offset[iswap] * row_size;
 #ifdef USE_MPI
+      if (sendproc[iswap] != me) {
+        // the swap index is the tag, as several swaps of a stage may connect
+        // the same pair of ranks
+        if (nrecv) {
+          requests.emplace_back();
+          MPI_Irecv(recv_buff, nrecv * tensor_size, mpi_type, recvproc[iswap],
+                    iswap, world, &requests.back());
+        }
+        if (nsend) {
+          requests.emplace_back();
+          MPI_Isend(send_buff, nsend * tensor_size, mpi_type, sendproc[iswap],
+                    iswap, world, &requests.back());
+        }
+        continue;
+      }
+#endif
+      // a swap with itself, where nsend equals nrecv
 #if defined(GOOGLE_CUDA) || defined(TENSORFLOW_USE_ROCM)
-    if (cuda_aware == 0) {
-      grad_output[0].copy_(d_local_g1_tensor);
-    }
+      if (on_device) {
+        gpuMemcpy(recv_buff, send_buff, nrecv * row_size,
+                  gpuMemcpyDeviceToDevice);
+        continue;
+      }
 #endif
+      memcpy(recv_buff, send_buff, nrecv * row_size);
+    }
+#ifdef USE_MPI
+    MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
 #endif
-
-    return {torch::Tensor(), torch::Tensor(), torch::Tensor(), torch::Tensor(),
-            torch::Tensor(), grad_output[0],  torch::Tensor(), torch::Tensor(),
-            torch::Tensor(), torch::Tensor()};
   }
 #ifdef USE_MPI
   static void unpack_communicator(const torch::Tensor& communicator_tensor,
@@ -1,11 +1,28 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 #include "custom_op.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "errors.h"
 
 namespace deepmd {
 void safe_compute(OpKernelContext* context,
                   std::function<void(OpKernelContext*)> ff) {
+#ifdef _OPENMP
+  // keep the OpenMP regions within the intra-op threads of the session;
+  // the calling thread may be shared by sessions, so restore it afterwards
+  const int last_omp_nthreads = omp_get_max_threads();
+  const DeviceBase::CpuWorkerThreads* workers =
+      context->device()->tensorflow_cpu_worker_threads();
+  const bool cap_omp_nthreads = workers != nullptr &&
+                                workers->num_threads > 0 &&
+                                workers->num_threads < last_omp_nthreads;
+  if (cap_omp_nthreads) {
+    omp_set_num_threads(workers->num_threads);
+  }
+#endif
   try {
     ff(context);
   } catch (deepmd::deepmd_exception_oom& e) {
@@ -17,5 +34,10 @@ void safe_compute(OpKernelContext* context,
         context, errors::Internal("Operation received an exception: ", e.what(),
                                   ", in file ", __FILE__, ":", __LINE__));
   }
+#ifdef _OPENMP
+  if (cap_omp_nthreads) {
+    omp_set_num_threads(last_omp_nthreads);
+  }
+#endif
 }
 };  // namespace deepmd
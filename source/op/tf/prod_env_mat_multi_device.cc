@@ -1,4 +1,7 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
+#include <cstdlib>
+#include <mutex>
+
 #include "coord.h"
 #include "custom_op.h"
 #include "device.h"
@@ -344,6 +347,8 @@ class ProdEnvMatAOp : public OpKernel {
     mem_cpy = 256;
     max_nnei_trial = 100;
     mem_nnei = 256;
+    const char* env_repair = std::getenv("DP_REPAIR_NLIST");
+    nlist_cache.repair = env_repair && std::string(env_repair) != "0";
   }
 
   void Compute(OpKernelContext* context) override {
@@ -613,9 +618,20 @@ class ProdEnvMatAOp : public OpKernel {
             max_nbor_size, box, mesh_tensor.flat<int>().data(), nloc, nei_mode,
             rcut_r, max_cpy_trial, max_nnei_trial);
         // launch the cpu compute function
-        deepmd::prod_env_mat_a_cpu(em, em_deriv, rij, nlist, coord, type,
-                                   inlist, max_nbor_size, avg, std, nloc,
-                                   frame_nall, rcut_r, rcut_r_smth, sec_a);
+        if (nei_mode == 3 && nsamples == 1) {
+          // the lammps neighbor list is unchanged until it is rebuilt, which
+          // is marked by ago == 0
+          const bool reuse_nlist = mesh_tensor.flat<int>()(0) > 0;
+          std::lock_guard<std::mutex> lock(nlist_cache_mutex);
+          deepmd::prod_env_mat_a_cpu(
+              em, em_deriv, rij, nlist, coord, type, inlist, max_nbor_size,
+              avg, std, nloc, frame_nall, rcut_r, rcut_r_smth, sec_a,
+              nlist_cache, reuse_nlist);
+        } else {
+          deepmd::prod_env_mat_a_cpu(em, em_deriv, rij, nlist, coord, type,
+                                     inlist, max_nbor_size, avg, std, nloc,
+                                     frame_nall, rcut_r, rcut_r_smth, sec_a);
+        }
         // do nlist mapping if coords were copied
         if (b_nlist_map) {
           _map_nlist_cpu(nlist, &idx_mapping[0], nloc, nnei);
@@ -642,6 +658,9 @@ class ProdEnvMatAOp : public OpKernel {
   unsigned long long* array_longlong = NULL;
   deepmd::InputNlist gpu_inlist;
   int* nbor_list_dev = NULL;
+  // formatted lammps neighbor list kept between two rebuilds
+  deepmd::EnvMatNlistCache nlist_cache;
+  std::mutex nlist_cache_mutex;
 };
 
 template <typename Device, typename FPTYPE>
@@ -975,6 +994,8 @@ class ProdEnvMatAMixOp : public OpKernel {
     mem_cpy = 256;
     max_nnei_trial = 100;
     mem_nnei = 256;
+    const char* env_repair = std::getenv("DP_REPAIR_NLIST");
+    nlist_cache.repair = env_repair && std::string(env_repair) != "0";
   }
 
   void Compute(OpKernelContext* context) override {
@@ -1276,9 +1297,20 @@ class ProdEnvMatAMixOp : public OpKernel {
             max_nbor_size, box, mesh_tensor.flat<int>().data(), nloc, nei_mode,
             rcut_r, max_cpy_trial, max_nnei_trial);
         // launch the cpu compute function
-        deepmd::prod_env_mat_a_cpu(
-            em, em_deriv, rij, nlist, coord, type, inlist, max_nbor_size, avg,
-            std, nloc, frame_nall, rcut_r, rcut_r_smth, sec_a, f_type);
+        if (nei_mode == 3 && nsamples == 1) {
+          // the lammps neighbor list is unchanged until it is rebuilt, which
+          // is marked by ago == 0
+          const bool reuse_nlist = mesh_tensor.flat<int>()(0) > 0;
+          std::lock_guard<std::mutex> lock(nlist_cache_mutex);
+          deepmd::prod_env_mat_a_cpu(
+              em, em_deriv, rij, nlist, coord, type, inlist, max_nbor_size,
+              avg, std, nloc, frame_nall, rcut_r, rcut_r_smth, sec_a,
+              nlist_cache, reuse_nlist, f_type);
+        } else {
+          deepmd::prod_env_mat_a_cpu(
+              em, em_deriv, rij, nlist, coord, type, inlist, max_nbor_size,
+              avg, std, nloc, frame_nall, rcut_r, rcut_r_smth, sec_a, f_type);
+        }
         // do nlist mapping if coords were copied
         _map_nei_info_cpu(nlist, ntype, nmask, type, &idx_mapping[0], nloc,
                           nnei, ntypes, b_nlist_map);
@@ -1304,6 +1336,9 @@ class ProdEnvMatAMixOp : public OpKernel {
   unsigned long long* array_longlong = NULL;
   deepmd::InputNlist gpu_inlist;
   int* nbor_list_dev = NULL;
+  // formatted lammps neighbor list kept between two rebuilds
+  deepmd::EnvMatNlistCache nlist_cache;
+  std::mutex nlist_cache_mutex;
 };
 
 template <typename FPTYPE>
@@ -0,0 +1,59 @@
+# SPDX-License-Identifier: LGPL-3.0-or-later
+import os
+import tempfile
+import unittest
+
+import numpy as np
+
+from deepmd.infer.model_devi import (
+    read_model_devi_atomic_bin,
+    restore_model_devi_atomic,
+)
+
+
+def write_frame(fp, step, natoms, tags, devi) -> None:
+    np.array([step, natoms, len(tags)], dtype=np.int64).tofile(fp)
+    np.array(tags, dtype=np.int64).tofile(fp)
+    np.array(devi, dtype=np.float64).tofile(fp)
+
+
+class TestModelDeviAtomicBin(unittest.TestCase):
+    def setUp(self) -> None:
+        self.tmpdir = tempfile.TemporaryDirectory()
+        self.out_file = os.path.join(self.tmpdir.name, "md.out")
+        self.atomic_file = os.path.join(self.tmpdir.name, "md_atomic.bin")
+        self.output = os.path.join(self.tmpdir.name, "md_restored.out")
+        with open(self.atomic_file, "wb") as fp:
+            # the blocks of two ranks, in the order of the ranks
+            write_frame(fp, 0, 4, [3, 4, 1, 2], [0.3, 0.4, 0.1, 0.2])
+            # sparse output, where atoms 1 and 3 are below the threshold
+            write_frame(fp, 10, 4, [4, 2], [0.8, 0.6])
+        with open(self.out_file, "w") as fp:
+            fp.write(
+                "#       step         max_devi_v         min_devi_v"
+                "         avg_devi_v         max_devi_f         min_devi_f"
+                "         avg_devi_f\n"
+            )
+            for step in (0, 10):
+                fp.write(f"{step:12d}" + "".join(f" {0.5:18.6e}" for _ in range(6)))
+                fp.write("\n")
+
+    def tearDown(self) -> None:
+        self.tmpdir.cleanup()
+
+    def test_read(self) -> None:
+        frames = read_model_devi_atomic_bin(self.atomic_file)
+        self.assertEqual([ff[0] for ff in frames], [0, 10])
+        np.testing.assert_allclose(frames[0][1], [0.1, 0.2, 0.3, 0.4])
+        np.testing.assert_allclose(frames[1][1], [0.0, 0.6, 0.0, 0.8])
+
+    def test_restore(self) -> None:
+        restore_model_devi_atomic(self.out_file, self.atomic_file, self.output)
+        with open(self.output) as fp:
+            lines = fp.read().splitlines()
+        self.assertTrue(lines[0].endswith("      atm_devi_f(N)"))
+        np.testing.assert_allclose(
+            np.loadtxt(self.output)[:, 7:],
+            [[0.1, 0.2, 0.3, 0.4], [0.0, 0.6, 0.0, 0.8]],
+        )
+        self.assertEqual(lines[1].split()[7], "1.000000e-01")